@@ -40,6 +40,7 @@ namespace clang {
 
 class ASTConsumer;
 class ASTContext;
+class ASTRecordLayout;
 class CXXBaseSpecifier;
 class CXXCtorInitializer;
 class CXXRecordDecl;
@@ -300,6 +301,17 @@ public:
       llvm::DenseMap<const CXXRecordDecl *, CharUnits> &BaseOffsets,
       llvm::DenseMap<const CXXRecordDecl *, CharUnits> &VirtualBaseOffsets);
 
+  /// Retrieve a layout for the given record definition that was computed
+  /// ahead of time, such as one stored in an AST file when it was built.
+  ///
+  /// Unlike a layout provided by \c layoutRecordType, this layout is used
+  /// as-is, without running the record layout builder.
+  ///
+  /// \returns the layout, allocated in the AST context, or null if the
+  /// external source has no layout for this record.
+  virtual const ASTRecordLayout *
+  getPrecomputedRecordLayout(const RecordDecl *Record);
+
   //===--------------------------------------------------------------------===//
   // Queries for performance analysis.
   //===--------------------------------------------------------------------===//
@@ -61,6 +61,8 @@ public:
 
 private:
   friend class ASTContext;
+  friend class ASTReader;
+  friend class ASTWriter;
 
   /// Size - Size of record in characters.
   CharUnits Size;
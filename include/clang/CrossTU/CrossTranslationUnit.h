@@ -67,6 +67,8 @@ private:
 ///
 /// The index file format is the following:
 /// each line consists of an USR and a filepath separated by a space.
+/// Index files in the binary format created by createCrossTUBinaryIndex are
+/// accepted as well.
 ///
 /// \return Returns a map where the USR is the key and the filepath is the value
 ///         or an error.
@@ -75,6 +77,12 @@ parseCrossTUIndex(StringRef IndexPath, StringRef CrossTUDir);
 
 std::string createCrossTUIndexString(const llvm::StringMap<std::string> &Index);
 
+/// Create the contents of an index file in the binary format.
+///
+/// The binary format is an on-disk hash table from USRs to filepaths, so
+/// looking up a definition needs neither parsing nor loading the whole index.
+std::string createCrossTUBinaryIndex(const llvm::StringMap<std::string> &Index);
+
 /// This class is used for tools that requires cross translation
 ///        unit capability.
 ///
@@ -122,6 +130,9 @@ public:
   /// function.
   ///
   /// Note that the AST files should also be in the \p CrossTUDir.
+  ///
+  /// The returned ASTUnit may be unloaded by later calls to
+  /// getCrossTUDefinition if the loaded ASTUnits exceed the memory limit.
   llvm::Expected<ASTUnit *> loadExternalAST(StringRef LookupName,
                                             StringRef CrossTUDir,
                                             StringRef IndexName);
@@ -139,14 +150,45 @@ public:
   /// Emit diagnostics for the user for potential configuration errors.
   void emitCrossTUDiagnostics(const IndexError &IE);
 
+  /// Limit the memory used by the loaded ASTUnits to approximately
+  /// \p MaxBytes. The least recently used ASTUnits are unloaded once the
+  /// limit is exceeded. Zero means no limit.
+  void setLoadedASTMemoryLimit(uint64_t MaxBytes) {
+    LoadedASTMemoryLimit = MaxBytes;
+  }
+
+  /// Look up the definitions by name in the external ASTs, which only
+  /// deserializes the declarations with that name, instead of visiting every
+  /// declaration of the AST.
+  void setLazyDefinitionLookup(bool Enabled) { LazyDefinitionLookup = Enabled; }
+
+  /// Returns the number of external ASTUnits that are currently loaded.
+  unsigned getNumLoadedASTUnits() const { return FileASTUnitMap.size(); }
+
 private:
+  class BinaryIndex;
+
   ASTImporter &getOrCreateASTImporter(ASTContext &From);
   const FunctionDecl *findFunctionInDeclContext(const DeclContext *DC,
                                                 StringRef LookupFnName);
+  const FunctionDecl *lookupFunctionByName(ASTContext &From,
+                                           const FunctionDecl *FD,
+                                           StringRef LookupFnName);
+  llvm::Expected<std::string> getASTFileName(StringRef LookupName,
+                                             StringRef CrossTUDir,
+                                             StringRef IndexName);
+  void unloadASTUnits(const ASTUnit *InUse);
 
   llvm::StringMap<std::unique_ptr<clang::ASTUnit>> FileASTUnitMap;
   llvm::StringMap<clang::ASTUnit *> FunctionASTUnitMap;
   llvm::StringMap<std::string> FunctionFileMap;
+  std::unique_ptr<BinaryIndex> FunctionFileIndex;
+  /// The last time each loaded ASTUnit was used, for unloading the least
+  /// recently used one first.
+  llvm::DenseMap<const ASTUnit *, uint64_t> ASTUnitLastUse;
+  uint64_t ASTUnitUseCount = 0;
+  uint64_t LoadedASTMemoryLimit = 0;
+  bool LazyDefinitionLookup = false;
   llvm::DenseMap<TranslationUnitDecl *, std::unique_ptr<ASTImporter>>
       ASTUnitImporterMap;
   CompilerInstance &CI;
@@ -134,6 +134,10 @@ public:
 
   std::map<std::string, std::string> DebugPrefixMap;
 
+  /// The file mapping record types to the translation unit that emits their
+  /// complete debug info, if non-empty.
+  std::string DebugTypeManifest;
+
   /// The ABI to use for passing floating point arguments.
   std::string FloatABI;
 
@@ -164,6 +168,24 @@ public:
   /// file, for example with -save-temps.
   std::string MainFileName;
 
+  /// The files that receive the code generated for each partition with
+  /// -fparallel-codegen. Linking them, e.g. with 'ld -r', is left to the
+  /// driver or build system.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
+  /// The directory used to cache the object code of -fparallel-codegen
+  /// partitions across compilations, if non-empty. Entries are keyed by the
+  /// optimized IR of a partition, so only code generation is skipped.
+  std::string ParallelCodeGenCachePath;
+
+  /// The pruning policy for ParallelCodeGenCachePath, as accepted by
+  /// llvm::parseCachePruningPolicy.
+  std::string ParallelCodeGenCachePruningPolicy;
+
+  /// The -mllvm arguments. They configure the backend through global options,
+  /// so they are part of the key of the code generation cache.
+  std::vector<std::string> LLVMArgs;
+
   /// The name for the split debug info file that we'll break out. This is used
   /// in the backend for setting the name in the skeleton cu.
   std::string SplitDwarfFile;
@@ -194,6 +216,14 @@ public:
   /// Name of the profile file to use as input for -fprofile-instr-use
   std::string ProfileInstrumentUsePath;
 
+  /// Name of a subset of ProfileInstrumentUsePath to look up function
+  /// profiles in first, as written by -fprofile-instrument-subset-output.
+  std::string ProfileInstrumentUseSubsetPath;
+
+  /// Name of the file to write the profile records used by this translation
+  /// unit to.
+  std::string ProfileInstrumentSubsetOutput;
+
   /// Name of the function summary index file to use for ThinLTO function
   /// importing.
   std::string ThinLTOIndexFile;
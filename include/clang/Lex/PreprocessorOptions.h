@@ -60,6 +60,18 @@ public:
   /// Headers that will be converted to chained PCHs in memory.
   std::vector<std::string> ChainedIncludes;
 
+  /// If non-empty, the directory where chained PCHs built for
+  /// \c ChainedIncludes are cached. A link of the chain whose inputs are
+  /// unchanged is reused instead of being rebuilt. This only applies to the
+  /// in-memory chain built for -chain-include, not to PCHs generated by
+  /// GeneratePCHAction.
+  std::string ChainedIncludesCachePath;
+
+  /// If non-empty, the file recording which declarations of the implicit PCH
+  /// were deserialized first. It is read to prefetch those declarations in
+  /// the background, and rewritten at the end of the translation unit.
+  std::string PCHPrefetchProfile;
+
   /// When true, disables most of the normal validation performed on
   /// precompiled headers.
   bool DisablePCHValidation = false;
@@ -180,8 +192,10 @@ public:
     Includes.clear();
     MacroIncludes.clear();
     ChainedIncludes.clear();
+    ChainedIncludesCachePath.clear();
     DumpDeserializedPCHDecls = false;
     ImplicitPCHInclude.clear();
+    PCHPrefetchProfile.clear();
     ImplicitPTHInclude.clear();
     TokenCache.clear();
     SingleFileParseMode = false;
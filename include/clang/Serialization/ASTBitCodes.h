@@ -648,7 +648,10 @@ namespace serialization {
       PP_CONDITIONAL_STACK = 62,
 
       /// A table of skipped ranges within the preprocessing record.
-      PPD_SKIPPED_RANGES = 63
+      PPD_SKIPPED_RANGES = 63,
+
+      /// Record code for the layouts of records defined in this AST file.
+      RECORD_LAYOUTS = 64
     };
 
     /// Record types used within a source manager block.
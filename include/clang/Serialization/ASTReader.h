@@ -62,6 +62,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/VersionTuple.h"
+#include "llvm/Support/thread.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -790,6 +791,15 @@ private:
   /// is the instantiation location.
   SmallVector<uint64_t, 64> PendingInstantiations;
 
+  /// The record definitions whose layouts were stored in the chain, mapped to
+  /// the module file and the position of the layout in its RecordLayouts.
+  llvm::DenseMap<serialization::GlobalDeclID, std::pair<ModuleFile *, unsigned>>
+      PrecomputedRecordLayouts;
+
+  /// The hash of the options that determine record layouts in this
+  /// compilation, computed the first time a stored layout is requested.
+  Optional<uint64_t> RecordLayoutHash;
+
   //@}
 
   /// \name DiagnosticsEngine-relevant special data
@@ -931,6 +941,31 @@ private:
   /// Whether we are allowed to use the global module index.
   bool UseGlobalIndex;
 
+  /// Whether identifier and selector lookups skip module files that do not
+  /// contain a visible module.
+  bool PruneUnreachableLookups;
+
+  /// The file recording which declarations of the PCH were needed, in
+  /// order, and which is used to prefetch them in the next translation unit.
+  std::string PrefetchProfilePath;
+
+  /// The PCH whose declaration reads are recorded, if any.
+  ModuleFile *PrefetchModule = nullptr;
+
+  /// The bit offsets of the declarations read from \c PrefetchModule, in
+  /// the order in which they were first needed.
+  std::vector<uint64_t> PrefetchProfileOffsets;
+
+  /// The maximum number of declarations recorded in a prefetch profile.
+  static const unsigned MaxPrefetchProfileSize = 1 << 16;
+
+  /// The background thread faulting in the parts of the PCH named by the
+  /// prefetch profile.
+  std::unique_ptr<llvm::thread> PrefetchThread;
+
+  /// The number of declarations prefetched from the prefetch profile.
+  unsigned NumPrefetchedDecls = 0;
+
   /// Whether we have tried loading the global module index yet.
   bool TriedLoadingGlobalIndex = false;
 
@@ -999,6 +1034,13 @@ private:
   /// The total number of method pool entries in the selector table.
   unsigned TotalNumMethodPoolEntries = 0;
 
+  /// The number of members of merged class definitions whose presence in
+  /// the canonical definition was established by comparing ODR hashes.
+  unsigned NumODRHashMergeChecksSkipped = 0;
+
+  /// The number of record layouts read instead of being recomputed.
+  unsigned NumRecordLayoutsRead = 0;
+
   /// Number of lexical decl contexts read/total.
   unsigned NumLexicalDeclContextsRead = 0, TotalLexicalDeclContexts = 0;
 
@@ -1034,6 +1076,12 @@ private:
   /// the last time we loaded information about this identifier.
   llvm::DenseMap<IdentifierInfo *, unsigned> IdentifierGeneration;
 
+  /// The generation at which the redeclaration chains named by each
+  /// identifier were last completed from every module file, including those
+  /// pruned from name lookups. Only used with
+  /// -fmodules-prune-unreachable-lookups.
+  llvm::DenseMap<IdentifierInfo *, unsigned> CompletedRedeclChainGeneration;
+
   class InterestingDecl {
     Decl *D;
     bool DeclHasPendingBody;
@@ -1088,6 +1136,12 @@ private:
   /// once recursing loading has been completed.
   llvm::SmallVector<NamedDecl *, 16> PendingOdrMergeChecks;
 
+  /// Class definitions that were merged into another definition with the
+  /// same ODR hash. Members of these definitions that the hash covers are
+  /// known to have a counterpart in the definition they were merged into,
+  /// so they need no entry in \c PendingOdrMergeChecks.
+  llvm::SmallPtrSet<DeclContext *, 16> ODRHashMatchedDefinitions;
+
   using DataPointers =
       std::pair<CXXRecordDecl *, struct CXXRecordDecl::DefinitionData *>;
 
@@ -1288,6 +1342,9 @@ private:
   ASTReadResult ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities);
   ASTReadResult ReadExtensionBlock(ModuleFile &F);
   void ReadModuleOffsetMap(ModuleFile &F) const;
+  void searchNewlyReachableModuleFiles(ArrayRef<ModuleFile *> ModuleFiles);
+  void lookupOutOfDateIdentifier(IdentifierInfo &II, bool IncludeUnreachable);
+  void startPrefetching(ModuleFile &F);
   bool ParseLineTable(ModuleFile &F, const RecordData &Record);
   bool ReadSourceManagerBlock(ModuleFile &F);
   llvm::BitstreamCursor &SLocCursorForID(int ID);
@@ -1928,6 +1985,11 @@ public:
   /// the ASTConsumer.
   void StartTranslationUnit(ASTConsumer *Consumer) override;
 
+  /// Write out the order in which declarations of the PCH were
+  /// deserialized, for use by \c -pch-prefetch-profile in later
+  /// translation units.
+  void writePrefetchProfile();
+
   /// Print some statistics about AST usage.
   void PrintStats() override;
 
@@ -2000,6 +2062,11 @@ public:
 
   void ReadUsedVTables(SmallVectorImpl<ExternalVTableUse> &VTables) override;
 
+  /// Read the layout of the given record definition, if the AST file that
+  /// defines it stored one that is valid for this compilation.
+  const ASTRecordLayout *
+  getPrecomputedRecordLayout(const RecordDecl *Record) override;
+
   void ReadPendingInstantiations(
                   SmallVectorImpl<std::pair<ValueDecl *,
                                             SourceLocation>> &Pending) override;
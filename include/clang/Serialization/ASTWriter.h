@@ -399,6 +399,10 @@ private:
   SmallVector<uint64_t, 16> EagerlyDeserializedDecls;
   SmallVector<uint64_t, 16> ModularCodegenDecls;
 
+  /// The record definitions written to this AST file whose layouts will be
+  /// stored in a RECORD_LAYOUTS record, when -fmodules-record-layouts is on.
+  SmallVector<const RecordDecl *, 16> RecordsToLayOut;
+
   /// DeclContexts that have received extensions since their serialized
   /// form.
   ///
@@ -505,6 +509,7 @@ private:
   void WriteOpenCLExtensionTypes(Sema &SemaRef);
   void WriteOpenCLExtensionDecls(Sema &SemaRef);
   void WriteCUDAPragmas(Sema &SemaRef);
+  void WriteRecordLayouts(ASTContext &Context);
   void WriteObjCCategories();
   void WriteLateParsedTemplates(Sema &SemaRef);
   void WriteOptimizePragmaOptions(Sema &SemaRef);
@@ -16,6 +16,7 @@
 #ifndef LLVM_CLANG_SERIALIZATION_GLOBALMODULEINDEX_H
 #define LLVM_CLANG_SERIALIZATION_GLOBALMODULEINDEX_H
 
+#include "clang/Basic/Module.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
@@ -87,6 +88,10 @@ class GlobalModuleIndex {
     /// index was built.
     time_t ModTime;
 
+    /// The signature of the module file at the time the global index was
+    /// built, if it has one.
+    ASTFileSignature Signature;
+
     /// The module IDs on which this module directly depends.
     /// FIXME: We don't really need a vector here.
     llvm::SmallVector<unsigned, 4> Dependencies;
@@ -193,6 +198,10 @@ public:
 
   /// Write a global index into the given
   ///
+  /// If an index already exists in \p Path, the entries it holds for
+  /// module files that have not changed since it was written are carried
+  /// over, and only new or modified module files are read.
+  ///
   /// \param FileMgr The file manager to use to load module files.
   /// \param PCHContainerRdr - The PCHContainerOperations to use for loading and
   /// creating modules.
@@ -108,7 +108,7 @@ public:
 class ModuleFile {
 public:
   ModuleFile(ModuleKind Kind, unsigned Generation)
-      : Kind(Kind), Generation(Generation) {}
+      : Kind(Kind), Generation(Generation), LookupGeneration(Generation) {}
   ~ModuleFile();
 
   // === General information ===
@@ -170,6 +170,15 @@ public:
 
   /// The generation of which this module file is a part.
   unsigned Generation;
+
+  /// The generation at which identifier and selector lookups started
+  /// searching this module file. This is later than \c Generation if the
+  /// module file was pruned from lookups when it was loaded.
+  unsigned LookupGeneration;
+
+  /// Whether identifier and selector lookups skip this module file because
+  /// no visible module is stored in it.
+  bool LookupPruned = false;
   
   /// The memory buffer that stores the data associated with
   /// this AST file, owned by the PCMCache in the ModuleManager.
@@ -439,6 +448,11 @@ public:
   /// module.
   SmallVector<uint64_t, 1> ObjCCategories;
 
+  /// The layouts of the records defined in this module, as stored in the
+  /// RECORD_LAYOUTS record. The first element is a hash of the options the
+  /// layouts were computed with.
+  SmallVector<uint64_t, 1> RecordLayouts;
+
   // === Types ===
 
   /// The number of types in this AST file.
@@ -0,0 +1,125 @@
+//===- AnalysisProfiler.h - Cost of checkers and functions ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines AnalysisProfiler, which records how much time and how
+//  many exploded nodes the path-sensitive analysis spends in each checker,
+//  each top-level function and each inlined callee.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_STATICANALYZER_CORE_ANALYSISPROFILER_H
+#define LLVM_CLANG_STATICANALYZER_CORE_ANALYSISPROFILER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace clang {
+
+class Decl;
+
+namespace ento {
+
+class CheckerBase;
+class ExplodedGraph;
+
+/// Collects the cost of the analysis of a translation unit.
+///
+/// The time of a checker is the time spent in its callbacks, excluding the
+/// callbacks of other checkers that it triggers, e.g. by making assumptions.
+/// The time of a top-level function includes everything done to analyze it.
+/// The time of an inlined callee is the time spent processing the work items
+/// of its stack frames, summed over all the places it was inlined in.
+class AnalysisProfiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Cost {
+    double Seconds = 0;
+    uint64_t Nodes = 0;
+    uint64_t Count = 0;
+  };
+
+  struct CalleeCost : Cost {
+    uint64_t NumInlined = 0;
+    uint64_t NumNotInlined = 0;
+  };
+
+  /// Measures the callbacks of one checker for as long as it is alive.
+  /// Does nothing if the profiler is null, so that the dispatch code does not
+  /// need to check whether profiling is enabled.
+  class CheckerScope {
+    AnalysisProfiler *Profiler;
+    const CheckerBase *Checker;
+    const ExplodedGraph *G;
+    unsigned NumCalls;
+    CheckerScope *Parent;
+    Clock::time_point Start;
+    unsigned StartNodes;
+    double NestedSeconds;
+    uint64_t NestedNodes;
+
+    void enter();
+    void exit();
+
+  public:
+    /// \param G The graph in which the checker creates nodes, if any.
+    /// \param NumCalls The number of callbacks run within the scope.
+    CheckerScope(AnalysisProfiler *Profiler, const CheckerBase *Checker,
+                 const ExplodedGraph *G = nullptr, unsigned NumCalls = 1)
+        : Profiler(Profiler), Checker(Checker), G(G), NumCalls(NumCalls) {
+      if (Profiler)
+        enter();
+    }
+
+    ~CheckerScope() {
+      if (Profiler)
+        exit();
+    }
+
+    CheckerScope(const CheckerScope &) = delete;
+    CheckerScope &operator=(const CheckerScope &) = delete;
+  };
+
+  /// Records the analysis of the top-level function \p D.
+  void addFunctionCost(const Decl *D, double Seconds, uint64_t Nodes);
+
+  /// Records the processing of a work item in an inlined call of \p D.
+  void addCalleeCost(const Decl *D, double Seconds, uint64_t Nodes);
+
+  /// Records whether a call to \p D was inlined or evaluated conservatively.
+  void recordInlining(const Decl *D, bool Inlined);
+
+  /// Prints the costs as tables sorted by decreasing time.
+  void printTable(raw_ostream &OS,
+                  llvm::function_ref<std::string(const Decl *)> GetName) const;
+
+  /// Prints the costs as a JSON object.
+  void printJSON(raw_ostream &OS,
+                 llvm::function_ref<std::string(const Decl *)> GetName) const;
+
+  static double secondsSince(Clock::time_point Start) {
+    return std::chrono::duration<double>(Clock::now() - Start).count();
+  }
+
+private:
+  CheckerScope *ActiveScope = nullptr;
+  llvm::MapVector<const CheckerBase *, Cost> CheckerCosts;
+  llvm::MapVector<const Decl *, Cost> FunctionCosts;
+  llvm::MapVector<const Decl *, CalleeCost> CalleeCosts;
+};
+
+} // namespace ento
+
+} // namespace clang
+
+#endif // LLVM_CLANG_STATICANALYZER_CORE_ANALYSISPROFILER_H
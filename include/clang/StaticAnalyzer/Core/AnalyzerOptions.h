@@ -194,6 +194,7 @@ public:
     UnexploredFirst,
     UnexploredFirstQueue,
     BFSBlockDFSContents,
+    InterleavedDFS,
     NotSet
   };
 
@@ -294,6 +295,12 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> AggressiveGraphTrimming;
+
+  /// \sa shouldBatchReportGraphs
+  Optional<bool> BatchReportGraphs;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -303,6 +310,12 @@ private:
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getAnalysisShardCount
+  Optional<unsigned> AnalysisShardCount;
+
+  /// \sa getAnalysisShardIndex
+  Optional<unsigned> AnalysisShardIndex;
+
   /// \sa shouldInlineLambdas
   Optional<bool> InlineLambdas;
 
@@ -327,6 +340,21 @@ private:
   /// \sa naiveCTUEnabled
   Optional<bool> NaiveCTU;
 
+  /// \sa getCTUMaxLoadedASTMemory
+  Optional<unsigned> CTUMaxLoadedASTMemory;
+
+  /// \sa shouldLookupCTUDefinitionsLazily
+  Optional<bool> CTULazyDefinitionLookup;
+
+  /// \sa getIncrementalCacheDir
+  Optional<StringRef> IncrementalCacheDir;
+
+  /// \sa shouldProfileAnalysis
+  Optional<bool> ProfileAnalysis;
+
+  /// \sa getAnalysisProfileOutput
+  Optional<StringRef> AnalysisProfileOutput;
+
 
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
@@ -640,6 +668,23 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if nodes in the ExplodedGraph that were not recyclable yet
+  /// when first considered, because nothing had been explored past them,
+  /// should be considered once more.
+  ///
+  /// This is controlled by the 'aggressive-graph-trimming' config option,
+  /// which accepts the values "true" and "false".
+  bool shouldTrimGraphAggressively();
+
+  /// Returns true if the ExplodedGraph is trimmed once for the paths of all
+  /// the bug reports of a function, instead of once per equivalence class and
+  /// diagnostic consumer. The path chosen among paths of the same length may
+  /// differ from the one chosen otherwise.
+  ///
+  /// This is controlled by the 'batch-report-graphs' config option,
+  /// which accepts the values "true" and "false".
+  bool shouldBatchReportGraphs();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -659,6 +704,21 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the number of analyzer invocations the path sensitive analysis
+  /// of the top level functions of a translation unit is split between, so
+  /// that they can run in parallel. Defaults to 1.
+  ///
+  /// This is controlled by the 'analysis-shard-count' config option.
+  unsigned getAnalysisShardCount();
+
+  /// Returns which of the getAnalysisShardCount() shards of the translation
+  /// unit this invocation analyzes, counting from 0. Only the first shard
+  /// runs the checks that are not path sensitive. The frontend rejects
+  /// indices that are not less than the shard count.
+  ///
+  /// This is controlled by the 'analysis-shard-index' config option.
+  unsigned getAnalysisShardIndex();
+
   /// Returns true if lambdas should be inlined. Otherwise a sink node will be
   /// generated each time a LambdaExpr is visited.
   bool shouldInlineLambdas();
@@ -703,6 +763,42 @@ public:
   /// This is an experimental feature to inline functions from another
   /// translation units.
   bool naiveCTUEnabled();
+
+  /// Returns the maximum memory in megabytes used by the ASTs loaded for
+  /// cross translation unit analysis. The least recently used ASTs are
+  /// unloaded above this limit. Zero means no limit.
+  ///
+  /// This is controlled by the 'ctu-max-loaded-ast-memory' config option.
+  unsigned getCTUMaxLoadedASTMemory();
+
+  /// Returns true if the definitions are looked up by name in the ASTs loaded
+  /// for cross translation unit analysis, which only deserializes the
+  /// declarations with that name instead of the whole AST.
+  ///
+  /// This is controlled by the 'ctu-lazy-definition-lookup' config option.
+  bool shouldLookupCTUDefinitionsLazily();
+
+  /// Returns the directory in which the results of earlier analyses are
+  /// cached, so that functions that are unchanged since an analysis found no
+  /// bugs in them are not analyzed again. Empty if there is no cache.
+  ///
+  /// This is controlled by the 'incremental-cache-dir' config option.
+  StringRef getIncrementalCacheDir();
+
+  /// Returns true if the time and the number of nodes spent in each checker,
+  /// each top-level function and each inlined callee should be recorded and
+  /// printed as tables at the end of the analysis of the translation unit.
+  ///
+  /// This is controlled by the 'profile-analysis' config option, which
+  /// defaults to false.
+  bool shouldProfileAnalysis();
+
+  /// Returns the path of the file to which the costs recorded by the analysis
+  /// profiler are written as JSON. Setting it also enables the profiling.
+  /// Empty if the costs are not written to a file.
+  ///
+  /// This is controlled by the 'profile-analysis-output' config option.
+  StringRef getAnalysisProfileOutput();
 };
   
 using AnalyzerOptionsRef = IntrusiveRefCntPtr<AnalyzerOptions>;
@@ -59,7 +59,9 @@ class ExplodedGraph;
 class ExplodedNode;
 class ExprEngine;
 class MemRegion;
+class SMTConstraintManager;
 class SValBuilder;
+class TrimmedGraph;
 
 //===----------------------------------------------------------------------===//
 // Interface for individual bug reports.
@@ -478,6 +480,9 @@ public:
     return true;
   }
 
+  /// Release the graphs shared by the paths of the reports flushed together.
+  virtual void clearReportGraphs() {}
+
   void Register(BugType *BT);
 
   /// Add the given report to the set of reports tracked by BugReporter.
@@ -510,6 +515,14 @@ private:
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
 
+  /// The exploded graph trimmed to the error nodes of all the reports being
+  /// flushed, if the paths of the reports are generated from a shared graph.
+  std::unique_ptr<TrimmedGraph> SharedTrimmedGraph;
+
+  /// The constraint manager checking the feasibility of the report paths,
+  /// kept across reports to reuse its solver and the results of its queries.
+  std::unique_ptr<SMTConstraintManager> RefutationMgr;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
       : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -528,6 +541,10 @@ public:
   ///  engine.
   ProgramStateManager &getStateManager();
 
+  /// Returns the constraint manager used to refute infeasible report paths,
+  /// with no constraints added.
+  SMTConstraintManager &getRefutationManager();
+
   /// Generates a path corresponding to one of the given bug reports.
   ///
   /// Which report is used for path generation is not specified. The
@@ -539,6 +556,8 @@ public:
   bool generatePathDiagnostic(PathDiagnostic &PD, PathDiagnosticConsumer &PC,
                               ArrayRef<BugReport*> &bugReports) override;
 
+  void clearReportGraphs() override;
+
   /// classof - Used by isa<>, cast<>, and dyn_cast<>.
   static bool classof(const BugReporter* R) {
     return R->getKind() == GRBugReporterKind;
@@ -37,6 +37,7 @@ class TranslationUnitDecl;
 namespace ento {
 
 class AnalysisManager;
+class AnalysisProfiler;
 class BugReporter;
 class CallEvent;
 class CheckerBase;
@@ -118,6 +119,7 @@ class CheckerManager {
   const LangOptions LangOpts;
   AnalyzerOptions &AOptions;
   CheckName CurrentCheckName;
+  AnalysisProfiler *Profiler = nullptr;
 
 public:
   CheckerManager(const LangOptions &langOpts, AnalyzerOptions &AOptions)
@@ -135,6 +137,11 @@ public:
   const LangOptions &getLangOpts() const { return LangOpts; }
   AnalyzerOptions &getAnalyzerOptions() { return AOptions; }
 
+  /// Sets the profiler that records the cost of the checker callbacks, or
+  /// null to stop recording.
+  void setProfiler(AnalysisProfiler *P) { Profiler = P; }
+  AnalysisProfiler *getProfiler() const { return Profiler; }
+
   using CheckerRef = CheckerBase *;
   using CheckerTag = const void *;
   using CheckerDtor = CheckerFn<void ()>;
@@ -289,6 +289,10 @@ protected:
   
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
+
+  /// Nodes that were still on the frontier the last time nodes were
+  /// reclaimed, to be considered once more the next time.
+  NodeVector FrontierNodes;
   
   /// A list of nodes that can be reused.
   NodeVector FreeNodes;
@@ -301,6 +305,10 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether nodes on the frontier are reconsidered for reclamation once they
+  /// have successors.
+  bool ReclaimFrontierNodes = false;
+
 public:
   ExplodedGraph();
   ~ExplodedGraph();
@@ -401,8 +409,12 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  ///
+  /// \param Aggressive Also reclaim the nodes that had no successor yet when
+  ///                   they were first considered.
+  void enableNodeReclamation(unsigned Interval, bool Aggressive = false) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    ReclaimFrontierNodes = Aggressive;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
@@ -697,6 +697,10 @@ private:
   bool inlineCall(const CallEvent &Call, const Decl *D, NodeBuilder &Bldr,
                   ExplodedNode *Pred, ProgramStateRef State);
 
+  /// Tells the analysis profiler, if any, that a call to \p D was evaluated
+  /// conservatively although its definition is available.
+  void recordNotInlined(const Decl *D);
+
   /// Conservatively evaluate call by invalidating regions and binding
   /// a conjured return value.
   void conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
@@ -17,6 +17,10 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SimpleConstraintManager.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/TrailingObjects.h"
+#include <memory>
 
 namespace clang {
 
@@ -61,51 +65,96 @@ public:
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are kept sorted and non-overlapping in a flat array. The
+/// Factory allocates the array once for each distinct set, so copying a
+/// RangeSet is copying a pointer and equal sets compare by pointer.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  class Factory;
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+private:
+  /// The uniqued ranges of a non-empty set.
+  class Storage final : public llvm::FoldingSetNode,
+                        private llvm::TrailingObjects<Storage, Range> {
+    friend TrailingObjects;
+    friend class RangeSet;
+    friend class Factory;
+
+    unsigned NumRanges;
+
+    explicit Storage(ArrayRef<Range> Ranges) : NumRanges(Ranges.size()) {
+      std::uninitialized_copy(Ranges.begin(), Ranges.end(),
+                              getTrailingObjects<Range>());
+    }
+
+    size_t numTrailingObjects(OverloadToken<Range>) const { return NumRanges; }
+
+  public:
+    ArrayRef<Range> ranges() const {
+      return {getTrailingObjects<Range>(), NumRanges};
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (const Range &R : Ranges)
+        R.Profile(ID);
+    }
+
+    void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, ranges()); }
+  };
+
+  /// The ranges of the set, or null if the set is empty.
+  const Storage *Impl;
+
+  explicit RangeSet(const Storage *Impl) : Impl(Impl) {}
+
+public:
+  class Factory {
+    llvm::BumpPtrAllocator Arena;
+    llvm::FoldingSet<Storage> Sets;
+
+  public:
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Return the set of \p Ranges, which must be sorted and must not
+    /// overlap.
+    RangeSet getSet(ArrayRef<Range> Ranges);
+  };
+
+  typedef const Range *iterator;
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
-  RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
-  }
+  RangeSet addRange(Factory &F, const RangeSet &RS) const;
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const {
+    return Impl ? Impl->ranges().begin() : nullptr;
+  }
+  iterator end() const { return Impl ? Impl->ranges().end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Impl; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-      : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+      : RangeSet(F.getSet(Range(from, to))) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Impl); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt *getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Impl && Impl->NumRanges == 1 ? begin()->getConcreteValue()
+                                        : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const;
+  void IntersectInRange(BasicValueFactory &BV, const llvm::APSInt &Lower,
+                        const llvm::APSInt &Upper,
+                        SmallVectorImpl<Range> &newRanges, iterator &i,
+                        iterator &e) const;
 
   const llvm::APSInt &getMinValue() const;
 
@@ -118,7 +167,7 @@ public:
   void print(raw_ostream &os) const;
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return Impl == other.Impl;
   }
 };
 
@@ -35,6 +35,10 @@ public:
   /// Checks if the added constraints are satisfiable
   virtual clang::ento::ConditionTruthVal isModelFeasible() = 0;
 
+  /// Removes the added constraints, so that the solver can be reused to check
+  /// another set of constraints.
+  virtual void resetConstraints() = 0;
+
 }; // end class SMTConstraintManager
 
 } // namespace ento
@@ -2975,7 +2975,13 @@ ASTContext::getASTRecordLayout(const RecordDecl *D) const {
 
   const ASTRecordLayout *NewEntry = nullptr;
 
-  if (isMsLayout(*this)) {
+  // An AST file may have stored the layout of the record when it was built.
+  if (ExternalASTSource *Source = getExternalSource())
+    NewEntry = Source->getPrecomputedRecordLayout(D);
+
+  if (NewEntry) {
+    // Nothing to compute.
+  } else if (isMsLayout(*this)) {
     MicrosoftRecordLayoutBuilder Builder(*this);
     if (const auto *RD = dyn_cast<CXXRecordDecl>(D)) {
       Builder.cxxLayout(RD);
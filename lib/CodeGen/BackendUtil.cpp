@@ -11,11 +11,13 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
@@ -37,10 +39,15 @@
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -58,8 +65,11 @@
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
+#include <atomic>
 #include <memory>
 using namespace clang;
 using namespace llvm;
@@ -100,12 +110,38 @@ class EmitAssemblyHelper {
   /// the requested target.
   void CreateTargetMachine(bool MustCreateTM);
 
+  /// Create a TargetMachine for \p TheTarget configured from our options.
+  std::unique_ptr<TargetMachine>
+  BuildTargetMachine(const llvm::Target &TheTarget) const;
+
   /// Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS, raw_pwrite_stream *DwoOS);
 
+  /// Add the code generator passes of \p Target to \p CodeGenPasses. Does
+  /// not report diagnostics, so that it can be used off the main thread.
+  ///
+  /// \return True on success.
+  bool AddCodeGenPasses(TargetMachine &Target,
+                        legacy::PassManager &CodeGenPasses,
+                        BackendAction Action, raw_pwrite_stream &OS,
+                        raw_pwrite_stream *DwoOS) const;
+
+  /// Compute the part of the partition cache key that does not depend
+  /// on the IR: the compiler version and the options code generation reads.
+  std::string getPartitionCacheKeyPrefix(BackendAction Action) const;
+
+  /// Split the module into OSs.size() partitions and run code generation on
+  /// each of them on its own thread, writing partition I to OSs[I]. With a
+  /// code generation cache, partitions whose IR is unchanged are copied from
+  /// the cache instead.
+  ///
+  /// \return True on success.
+  bool EmitPartitionsInParallel(BackendAction Action,
+                                ArrayRef<raw_pwrite_stream *> OSs);
+
   std::unique_ptr<llvm::ToolOutputFile> openOutputFile(StringRef Path) {
     std::error_code EC;
     auto F = llvm::make_unique<llvm::ToolOutputFile>(Path, EC,
@@ -698,6 +734,11 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
     return;
   }
 
+  TM = BuildTargetMachine(*TheTarget);
+}
+
+std::unique_ptr<TargetMachine>
+EmitAssemblyHelper::BuildTargetMachine(const llvm::Target &TheTarget) const {
   Optional<llvm::CodeModel::Model> CM = getCodeModel(CodeGenOpts);
   std::string FeaturesStr =
       llvm::join(TargetOpts.Features.begin(), TargetOpts.Features.end(), ",");
@@ -706,16 +747,30 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
 
   llvm::TargetOptions Options;
   initTargetOptions(Options, CodeGenOpts, TargetOpts, LangOpts, HSOpts);
-  TM.reset(TheTarget->createTargetMachine(Triple, TargetOpts.CPU, FeaturesStr,
-                                          Options, RM, CM, OptLevel));
+  return std::unique_ptr<TargetMachine>(TheTarget.createTargetMachine(
+      TheModule->getTargetTriple(), TargetOpts.CPU, FeaturesStr, Options, RM,
+      CM, OptLevel));
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
                                        BackendAction Action,
                                        raw_pwrite_stream &OS,
                                        raw_pwrite_stream *DwoOS) {
+  if (!AddCodeGenPasses(*TM, CodeGenPasses, Action, OS, DwoOS)) {
+    Diags.Report(diag::err_fe_unable_to_interface_with_target);
+    return false;
+  }
+
+  return true;
+}
+
+bool EmitAssemblyHelper::AddCodeGenPasses(TargetMachine &Target,
+                                          legacy::PassManager &CodeGenPasses,
+                                          BackendAction Action,
+                                          raw_pwrite_stream &OS,
+                                          raw_pwrite_stream *DwoOS) const {
   // Add LibraryInfo.
-  llvm::Triple TargetTriple(TheModule->getTargetTriple());
+  llvm::Triple TargetTriple(Target.getTargetTriple());
   std::unique_ptr<TargetLibraryInfoImpl> TLII(
       createTLII(TargetTriple, CodeGenOpts));
   CodeGenPasses.add(new TargetLibraryInfoWrapperPass(*TLII));
@@ -730,12 +785,261 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   if (CodeGenOpts.OptimizationLevel > 0)
     CodeGenPasses.add(createObjCARCContractPass());
 
-  if (TM->addPassesToEmitFile(CodeGenPasses, OS, DwoOS, CGFT,
-                              /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+  return !Target.addPassesToEmitFile(
+      CodeGenPasses, OS, DwoOS, CGFT,
+      /*DisableVerify=*/!CodeGenOpts.VerifyModule);
+}
+
+std::string
+EmitAssemblyHelper::getPartitionCacheKeyPrefix(BackendAction Action) const {
+  llvm::MD5 Hash;
+  auto AddInt = [&Hash](uint64_t V) {
+    Hash.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(&V),
+                                  sizeof(V)));
+  };
+  auto AddString = [&](StringRef S) {
+    AddInt(S.size());
+    Hash.update(S);
+  };
+
+  // Be conservative and hash every code generation, target and language
+  // option, including ones that only matter to the frontend. Only the files
+  // that this compilation writes are left out.
+  AddString(getClangFullRepositoryVersion());
+  AddInt(Action);
+#define CODEGENOPT(Name, Bits, Default) AddInt(CodeGenOpts.Name);
+#define ENUM_CODEGENOPT(Name, Type, Bits, Default)                             \
+  AddInt(static_cast<uint64_t>(CodeGenOpts.get##Name()));
+#include "clang/Frontend/CodeGenOptions.def"
+#define LANGOPT(Name, Bits, Default, Description) AddInt(LangOpts.Name);
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description)                   \
+  AddInt(static_cast<uint64_t>(LangOpts.get##Name()));
+#define BENIGN_LANGOPT(Name, Bits, Default, Description)
+#define BENIGN_ENUM_LANGOPT(Name, Type, Bits, Default, Description)
+#include "clang/Basic/LangOptions.def"
+  auto AddStrings = [&](ArrayRef<std::string> Strings) {
+    AddInt(Strings.size());
+    for (const std::string &S : Strings)
+      AddString(S);
+  };
+  AddString(CodeGenOpts.CodeModel);
+  AddString(CodeGenOpts.DebugPass);
+  AddString(CodeGenOpts.DebugCompilationDir);
+  AddString(CodeGenOpts.DwarfDebugFlags);
+  AddInt(CodeGenOpts.DebugPrefixMap.size());
+  for (const auto &Prefix : CodeGenOpts.DebugPrefixMap) {
+    AddString(Prefix.first);
+    AddString(Prefix.second);
+  }
+  AddString(CodeGenOpts.FloatABI);
+  AddString(CodeGenOpts.FPDenormalMode);
+  AddString(CodeGenOpts.LimitFloatPrecision);
+  AddString(CodeGenOpts.MainFileName);
+  AddString(CodeGenOpts.SplitDwarfFile);
+  AddInt(CodeGenOpts.RelocationModel);
+  AddString(CodeGenOpts.ThreadModel);
+  AddString(CodeGenOpts.TrapFuncName);
+  AddStrings(CodeGenOpts.DependentLibraries);
+  AddStrings(CodeGenOpts.LinkerOptions);
+  AddStrings(CodeGenOpts.RewriteMapFiles);
+  AddInt(CodeGenOpts.SanitizeRecover.Mask);
+  AddInt(CodeGenOpts.SanitizeTrap.Mask);
+  AddStrings(CodeGenOpts.getNoBuiltinFuncs());
+  AddStrings(CodeGenOpts.Reciprocals);
+  AddString(CodeGenOpts.PreferVectorWidth);
+  AddInt(CodeGenOpts.XRayInstrumentationBundle.Mask);
+  AddStrings(CodeGenOpts.LLVMArgs);
+  AddString(TargetOpts.Triple);
+  AddString(TargetOpts.HostTriple);
+  AddString(TargetOpts.CPU);
+  AddString(TargetOpts.FPMath);
+  AddString(TargetOpts.ABI);
+  AddInt(static_cast<uint64_t>(TargetOpts.EABIVersion));
+  AddString(TargetOpts.LinkerVersion);
+  AddStrings(TargetOpts.FeaturesAsWritten);
+  AddStrings(TargetOpts.Features);
+  AddInt(TargetOpts.ForceEnableInt128);
+  AddInt(TargetOpts.NVPTXUseShortPointers);
+  // The header search paths end up in the debug info of imported modules.
+  AddString(HSOpts.Sysroot);
+  AddString(HSOpts.ResourceDir);
+  AddString(HSOpts.ModuleCachePath);
+  AddInt(HSOpts.UserEntries.size());
+  for (const HeaderSearchOptions::Entry &Entry : HSOpts.UserEntries) {
+    AddString(Entry.Path);
+    AddInt(Entry.Group);
+    AddInt(Entry.IsFramework);
+    AddInt(Entry.IgnoreSysRoot);
+  }
+
+  llvm::MD5::MD5Result Result;
+  SmallString<32> Key;
+  Hash.final(Result);
+  llvm::MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+/// Remove the declarations that SplitModule leaves in a partition but that
+/// nothing in it uses, so that the partition's cache key only depends on what
+/// the partition references. Hidden and weak declarations are kept, because
+/// the object file mentions them even when they are unused.
+static void pruneUnusedDeclarations(Module &M) {
+  auto IsPrunable = [](const GlobalValue &GV) {
+    return GV.isDeclaration() && GV.use_empty() &&
+           GV.hasDefaultVisibility() && !GV.hasExternalWeakLinkage();
+  };
+  for (auto I = M.begin(), E = M.end(); I != E;) {
+    Function &F = *I++;
+    if (IsPrunable(F) && !F.isIntrinsic())
+      F.eraseFromParent();
+  }
+  for (auto I = M.global_begin(), E = M.global_end(); I != E;) {
+    GlobalVariable &GV = *I++;
+    if (IsPrunable(GV))
+      GV.eraseFromParent();
+  }
+}
+
+/// Atomically store \p Data as the cache entry \p Path.
+static void writePartitionCacheFile(StringRef Path, StringRef Data) {
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return;
+
+  raw_fd_ostream Out(FD, /*shouldClose=*/true);
+  Out << Data;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return;
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
+bool EmitAssemblyHelper::EmitPartitionsInParallel(
+    BackendAction Action, ArrayRef<raw_pwrite_stream *> OSs) {
+  const llvm::Target &TheTarget = TM->getTarget();
+  std::atomic<bool> Failed(false);
+
+  StringRef CacheDir = CodeGenOpts.ParallelCodeGenCachePath;
+  std::string CacheKeyPrefix;
+  if (!CacheDir.empty()) {
+    if (llvm::sys::fs::create_directories(CacheDir))
+      CacheDir = StringRef();
+    else
+      CacheKeyPrefix = getPartitionCacheKeyPrefix(Action);
+  }
+
+  // SplitModule consumes the module it splits, and ours belongs to the caller.
+  std::unique_ptr<Module> Clone = CloneModule(*TheModule);
+
+  {
+    // Destroying the pool joins the code generation threads.
+    ThreadPool CodeGenThreadPool(OSs.size());
+    unsigned Partition = 0;
+
+    // Local symbols are kept local, in the same partition as all their uses,
+    // so that the partitions link exactly like the unsplit object would.
+    SplitModule(
+        std::move(Clone), OSs.size(),
+        [&](std::unique_ptr<Module> MPart) {
+          if (!CacheDir.empty())
+            pruneUnusedDeclarations(*MPart);
+
+          // Every thread needs its own LLVMContext, so hand the partition
+          // over as bitcode.
+          SmallString<0> BC;
+          raw_svector_ostream BCOS(BC);
+          WriteBitcodeToFile(*MPart, BCOS);
+
+          unsigned ThisPartition = Partition++;
+          raw_pwrite_stream *OS = OSs[ThisPartition];
+
+          // The partition's bitcode is the whole input to code generation,
+          // so together with the options it identifies the output exactly.
+          std::string CachePath;
+          if (!CacheDir.empty()) {
+            llvm::MD5 Hash;
+            llvm::MD5::MD5Result Result;
+            SmallString<32> Key;
+            Hash.update(CacheKeyPrefix);
+            Hash.update(BC);
+            Hash.final(Result);
+            llvm::MD5::stringifyResult(Result, Key);
+
+            // pruneCache only considers files with the "llvmcache" prefix.
+            SmallString<128> Path(CacheDir);
+            llvm::sys::path::append(Path, "llvmcache-" + Key);
+            CachePath = Path.str();
+            if (auto Cached = MemoryBuffer::getFile(CachePath)) {
+              Diags.Report(diag::remark_partition_cache_hit) << ThisPartition;
+              *OS << (*Cached)->getBuffer();
+              return;
+            }
+            Diags.Report(diag::remark_partition_cache_miss) << ThisPartition;
+          }
+
+          CodeGenThreadPool.async(
+              [this, &TheTarget, &Failed, Action, OS,
+               CachePath](const SmallString<0> &BC) {
+                LLVMContext Ctx;
+                Expected<std::unique_ptr<Module>> MPartOrErr = parseBitcodeFile(
+                    MemoryBufferRef(StringRef(BC.data(), BC.size()),
+                                    "<split-module>"),
+                    Ctx);
+                if (!MPartOrErr) {
+                  consumeError(MPartOrErr.takeError());
+                  Failed = true;
+                  return;
+                }
+
+                std::unique_ptr<TargetMachine> PartTM =
+                    BuildTargetMachine(TheTarget);
+                legacy::PassManager CodeGenPasses;
+                CodeGenPasses.add(createTargetTransformInfoWrapperPass(
+                    PartTM->getTargetIRAnalysis()));
+                // Generate into memory first when the result also goes into
+                // the cache.
+                SmallString<0> Output;
+                raw_svector_ostream OutputOS(Output);
+                raw_pwrite_stream &PartOS =
+                    CachePath.empty() ? *OS : OutputOS;
+                if (!AddCodeGenPasses(*PartTM, CodeGenPasses, Action, PartOS,
+                                      /*DwoOS=*/nullptr)) {
+                  Failed = true;
+                  return;
+                }
+                CodeGenPasses.run(**MPartOrErr);
+
+                if (!CachePath.empty()) {
+                  *OS << Output;
+                  writePartitionCacheFile(CachePath, Output);
+                }
+              },
+              std::move(BC));
+        },
+        /*PreserveLocals=*/true);
+  }
+
+  if (!CacheDir.empty()) {
+    // The policy was validated when the options were parsed.
+    Expected<CachePruningPolicy> Policy =
+        parseCachePruningPolicy(
+            CodeGenOpts.ParallelCodeGenCachePruningPolicy);
+    if (Policy)
+      pruneCache(CacheDir, *Policy);
+    else
+      consumeError(Policy.takeError());
+  }
+
+  if (Failed) {
     Diags.Report(diag::err_fe_unable_to_interface_with_target);
     return false;
   }
-
   return true;
 }
 
@@ -770,6 +1074,8 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
       createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
 
   std::unique_ptr<llvm::ToolOutputFile> ThinLinkOS, DwoOS;
+  std::vector<std::unique_ptr<llvm::ToolOutputFile>> PartitionFiles;
+  SmallVector<raw_pwrite_stream *, 4> PartitionOSs;
 
   switch (Action) {
   case Backend_EmitNothing:
@@ -801,6 +1107,15 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
       if (!DwoOS)
         return;
     }
+    if (CodeGenOpts.ParallelCodeGen > 1) {
+      for (const std::string &Path : CodeGenOpts.ParallelCodeGenOutputs) {
+        PartitionFiles.push_back(openOutputFile(Path));
+        if (!PartitionFiles.back())
+          return;
+        PartitionOSs.push_back(&PartitionFiles.back()->os());
+      }
+      break;
+    }
     if (!AddEmitPasses(CodeGenPasses, Action, *OS,
                        DwoOS ? &DwoOS->os() : nullptr))
       return;
@@ -829,13 +1144,20 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    if (!PartitionOSs.empty()) {
+      if (!EmitPartitionsInParallel(Action, PartitionOSs))
+        return;
+    } else {
+      CodeGenPasses.run(*TheModule);
+    }
   }
 
   if (ThinLinkOS)
     ThinLinkOS->keep();
   if (DwoOS)
     DwoOS->keep();
+  for (auto &PartitionFile : PartitionFiles)
+    PartitionFile->keep();
 }
 
 static PassBuilder::OptimizationLevel mapToLevel(const CodeGenOptions &Opts) {
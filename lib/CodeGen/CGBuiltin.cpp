@@ -45,6 +45,38 @@ int64_t clamp(int64_t Value, int64_t Low, int64_t High) {
   return std::min(High, std::max(Low, Value));
 }
 
+CodeGenModule::BuiltinLoweringInfo
+CodeGenModule::getBuiltinLoweringInfo(unsigned BuiltinID) {
+  auto Cached = BuiltinLowerings.find(BuiltinID);
+  if (Cached != BuiltinLowerings.end())
+    return Cached->second;
+
+  // Both the intrinsic tables and the builtin type strings are searched and
+  // decoded by name, so do it once per builtin rather than at every call of
+  // an intrinsic-heavy translation unit.
+  BuiltinLoweringInfo Info = {Intrinsic::not_intrinsic, 0};
+  const char *Name = Context.BuiltinInfo.getName(BuiltinID);
+  StringRef Prefix =
+      llvm::Triple::getArchTypePrefix(getTarget().getTriple().getArch());
+  if (!Prefix.empty()) {
+    Info.IntrinsicID =
+        Intrinsic::getIntrinsicForGCCBuiltin(Prefix.data(), Name);
+    // NOTE we don't need to perform a compatibility flag check here since the
+    // intrinsics are declared in Builtins*.def via LANGBUILTIN which filter the
+    // MS builtins via ALL_MS_LANGUAGES and are filtered earlier.
+    if (Info.IntrinsicID == Intrinsic::not_intrinsic)
+      Info.IntrinsicID =
+          Intrinsic::getIntrinsicForMSBuiltin(Prefix.data(), Name);
+  }
+
+  ASTContext::GetBuiltinTypeError Error;
+  Context.GetBuiltinType(BuiltinID, Error, &Info.ICEArguments);
+  assert(Error == ASTContext::GE_None && "Should not codegen an error");
+
+  BuiltinLowerings[BuiltinID] = Info;
+  return Info;
+}
+
 /// getBuiltinLibFunction - Given a builtin id for a function like
 /// "__builtin_fabsf", return a Function* for "fabsf".
 llvm::Constant *CodeGenModule::getBuiltinLibFunction(const FunctionDecl *FD,
@@ -3655,30 +3687,16 @@ RValue CodeGenFunction::EmitBuiltinExpr(const FunctionDecl *FD,
   checkTargetFeatures(E, FD);
 
   // See if we have a target specific intrinsic.
-  const char *Name = getContext().BuiltinInfo.getName(BuiltinID);
-  Intrinsic::ID IntrinsicID = Intrinsic::not_intrinsic;
-  StringRef Prefix =
-      llvm::Triple::getArchTypePrefix(getTarget().getTriple().getArch());
-  if (!Prefix.empty()) {
-    IntrinsicID = Intrinsic::getIntrinsicForGCCBuiltin(Prefix.data(), Name);
-    // NOTE we don't need to perform a compatibility flag check here since the
-    // intrinsics are declared in Builtins*.def via LANGBUILTIN which filter the
-    // MS builtins via ALL_MS_LANGUAGES and are filtered earlier.
-    if (IntrinsicID == Intrinsic::not_intrinsic)
-      IntrinsicID = Intrinsic::getIntrinsicForMSBuiltin(Prefix.data(), Name);
-  }
-
-  if (IntrinsicID != Intrinsic::not_intrinsic) {
+  CodeGenModule::BuiltinLoweringInfo Lowering =
+      CGM.getBuiltinLoweringInfo(BuiltinID);
+  if (Lowering.IntrinsicID != Intrinsic::not_intrinsic) {
     SmallVector<Value*, 16> Args;
 
     // Find out if any arguments are required to be integer constant
     // expressions.
-    unsigned ICEArguments = 0;
-    ASTContext::GetBuiltinTypeError Error;
-    getContext().GetBuiltinType(BuiltinID, Error, &ICEArguments);
-    assert(Error == ASTContext::GE_None && "Should not codegen an error");
+    unsigned ICEArguments = Lowering.ICEArguments;
 
-    Function *F = CGM.getIntrinsic(IntrinsicID);
+    Function *F = CGM.getIntrinsic(Lowering.IntrinsicID);
     llvm::FunctionType *FTy = F->getFunctionType();
 
     for (unsigned i = 0, e = E->getNumArgs(); i != e; ++i) {
@@ -5805,10 +5823,7 @@ Value *CodeGenFunction::EmitARMBuiltinExpr(unsigned BuiltinID,
 
   // Find out if any arguments are required to be integer constant
   // expressions.
-  unsigned ICEArguments = 0;
-  ASTContext::GetBuiltinTypeError Error;
-  getContext().GetBuiltinType(BuiltinID, Error, &ICEArguments);
-  assert(Error == ASTContext::GE_None && "Should not codegen an error");
+  unsigned ICEArguments = CGM.getBuiltinLoweringInfo(BuiltinID).ICEArguments;
 
   auto getAlignmentValue32 = [&](Address addr) -> Value* {
     return Builder.getInt32(addr.getAlignment().getQuantity());
@@ -6603,10 +6618,7 @@ Value *CodeGenFunction::EmitAArch64BuiltinExpr(unsigned BuiltinID,
 
   // Find out if any arguments are required to be integer constant
   // expressions.
-  unsigned ICEArguments = 0;
-  ASTContext::GetBuiltinTypeError Error;
-  getContext().GetBuiltinType(BuiltinID, Error, &ICEArguments);
-  assert(Error == ASTContext::GE_None && "Should not codegen an error");
+  unsigned ICEArguments = CGM.getBuiltinLoweringInfo(BuiltinID).ICEArguments;
 
   llvm::SmallVector<Value*, 4> Ops;
   for (unsigned i = 0, e = E->getNumArgs() - 1; i != e; i++) {
@@ -8933,10 +8945,7 @@ Value *CodeGenFunction::EmitX86BuiltinExpr(unsigned BuiltinID,
   SmallVector<Value*, 4> Ops;
 
   // Find out if any arguments are required to be integer constant expressions.
-  unsigned ICEArguments = 0;
-  ASTContext::GetBuiltinTypeError Error;
-  getContext().GetBuiltinType(BuiltinID, Error, &ICEArguments);
-  assert(Error == ASTContext::GE_None && "Should not codegen an error");
+  unsigned ICEArguments = CGM.getBuiltinLoweringInfo(BuiltinID).ICEArguments;
 
   for (unsigned i = 0, e = E->getNumArgs(); i != e; i++) {
     // If this is a normal argument, just emit it as a scalar.
@@ -67,9 +67,42 @@ CGDebugInfo::CGDebugInfo(CodeGenModule &CGM)
       DBuilder(CGM.getModule()) {
   for (const auto &KV : CGM.getCodeGenOpts().DebugPrefixMap)
     DebugPrefixMap[KV.first] = KV.second;
+  if (!CGM.getCodeGenOpts().DebugTypeManifest.empty())
+    loadTypeManifest();
   CreateCompileUnit();
 }
 
+void CGDebugInfo::loadTypeManifest() {
+  StringRef Path = CGM.getCodeGenOpts().DebugTypeManifest;
+  auto BufOrErr = llvm::MemoryBuffer::getFile(Path);
+  if (!BufOrErr) {
+    CGM.getDiags().Report(diag::err_cannot_open_file)
+        << Path << BufOrErr.getError().message();
+    return;
+  }
+
+  // Each line names a record type by its qualified name, including the
+  // template arguments of a class template specialization, followed by a tab and the path of the main file of its home
+  // translation unit as it is passed to the compiler. Both may contain
+  // spaces. Lines starting with '#' are comments.
+  StringRef ThisTU = CGM.getModule().getName();
+  SmallVector<StringRef, 16> Lines;
+  (*BufOrErr)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                 /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    Line = Line.trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+    StringRef Name, Home;
+    std::tie(Name, Home) = Line.split('\t');
+    Name = Name.trim();
+    Home = Home.trim();
+    if (Name.empty() || Home.empty())
+      continue;
+    TypeManifest[Name] = Home == ThisTU;
+  }
+}
+
 CGDebugInfo::~CGDebugInfo() {
   assert(LexicalBlockStack.empty() &&
          "Region stack mismatch, stack not empty!");
@@ -1916,6 +1949,10 @@ void CGDebugInfo::completeClassData(const RecordDecl *RD) {
   if (DebugTypeExtRefs && isDefinedInClangModule(RD->getDefinition()))
     return;
 
+  if (Optional<bool> IsHome = isTypeManifestHome(RD))
+    if (!*IsHome)
+      return;
+
   completeClass(RD);
 }
 
@@ -1988,8 +2025,37 @@ static bool shouldOmitDefinition(codegenoptions::DebugInfoKind DebugKind,
   return false;
 }
 
+Optional<bool> CGDebugInfo::isTypeManifestHome(const RecordDecl *RD) const {
+  if (TypeManifest.empty() || RD->getName().empty())
+    return None;
+  // Every translation unit has its own copy of a type that is not externally
+  // visible, so no other translation unit can be its home.
+  if (!RD->isExternallyVisible())
+    return None;
+  // Different specializations of a class template can be instantiated in
+  // different translation units, so each has its own entry.
+  std::string Name;
+  llvm::raw_string_ostream OS(Name);
+  RD->getNameForDiagnostic(OS, getPrintingPolicy(), /*Qualified=*/true);
+  auto I = TypeManifest.find(OS.str());
+  if (I == TypeManifest.end())
+    return None;
+  return I->second;
+}
+
+bool CGDebugInfo::shouldOmitTypeDefinition(const RecordDecl *RD) const {
+  // The manifest overrides the heuristics in both directions: a type's home
+  // emits its complete definition even where the type is never required to
+  // be complete, and every other translation unit only references it.
+  if (Optional<bool> IsHome = isTypeManifestHome(RD))
+    return !*IsHome;
+
+  return shouldOmitDefinition(DebugKind, DebugTypeExtRefs, RD,
+                              CGM.getLangOpts());
+}
+
 void CGDebugInfo::completeRequiredType(const RecordDecl *RD) {
-  if (shouldOmitDefinition(DebugKind, DebugTypeExtRefs, RD, CGM.getLangOpts()))
+  if (shouldOmitTypeDefinition(RD))
     return;
 
   QualType Ty = CGM.getContext().getRecordType(RD);
@@ -2001,8 +2067,7 @@ void CGDebugInfo::completeRequiredType(const RecordDecl *RD) {
 llvm::DIType *CGDebugInfo::CreateType(const RecordType *Ty) {
   RecordDecl *RD = Ty->getDecl();
   llvm::DIType *T = cast_or_null<llvm::DIType>(getTypeOrNull(QualType(Ty, 0)));
-  if (T || shouldOmitDefinition(DebugKind, DebugTypeExtRefs, RD,
-                                CGM.getLangOpts())) {
+  if (T || shouldOmitTypeDefinition(RD)) {
     if (!T)
       T = getOrCreateRecordFwdDecl(Ty, getDeclContextDescriptor(RD));
     return T;
@@ -25,6 +25,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/ValueHandle.h"
@@ -82,6 +83,10 @@ class CGDebugInfo {
 
   llvm::SmallDenseMap<llvm::StringRef, llvm::StringRef> DebugPrefixMap;
 
+  /// Record types named in the -fdebug-type-manifest file, mapped to whether
+  /// this translation unit is their home, i.e. emits their complete debug info.
+  llvm::StringMap<bool> TypeManifest;
+
   /// Cache that maps VLA types to size expressions for that type,
   /// represented by instantiated Metadata nodes.
   llvm::SmallDenseMap<QualType, llvm::Metadata *> SizeExprCache;
@@ -496,6 +501,17 @@ private:
   /// Create new compile unit.
   void CreateCompileUnit();
 
+  /// Read the -fdebug-type-manifest file into TypeManifest.
+  void loadTypeManifest();
+
+  /// If \p RD is listed in the type manifest, whether this translation unit
+  /// is its home.
+  Optional<bool> isTypeManifestHome(const RecordDecl *RD) const;
+
+  /// Whether to emit only a declaration of \p RD, because its complete
+  /// definition is emitted by another translation unit.
+  bool shouldOmitTypeDefinition(const RecordDecl *RD) const;
+
   /// Remap a given path with the current debug prefix map
   std::string remapDIPath(StringRef) const;
 
@@ -881,6 +881,18 @@ CodeGenModule::getVTableLinkage(const CXXRecordDecl *RD) {
 /// functions).  For weak vtables, CodeGen tracks when they are needed and
 /// emits them as-needed.
 void CodeGenModule::EmitVTable(CXXRecordDecl *theClass) {
+  // A vtable that may be discarded if unused is queued in DeferredVTables as
+  // soon as emitted code references it, so there is no need to emit it (and
+  // every virtual function it references) just because Sema marked it used.
+  // Its class still gets the debug info that comes with the vtable.
+  if (shouldPruneDeferredDecls() &&
+      llvm::GlobalValue::isDiscardableIfUnused(getVTableLinkage(theClass))) {
+    if (CGDebugInfo *DI = getModuleDebugInfo())
+      DI->completeClassData(theClass);
+    SkippedVTables.insert(theClass);
+    return;
+  }
+
   VTables.GenerateClassData(theClass);
 }
 
@@ -960,10 +972,12 @@ void CodeGenModule::EmitDeferredVTables() {
 #endif
 
   for (const CXXRecordDecl *RD : DeferredVTables)
-    if (shouldEmitVTableAtEndOfTranslationUnit(*this, RD))
+    if (shouldEmitVTableAtEndOfTranslationUnit(*this, RD)) {
       VTables.GenerateClassData(RD);
-    else if (shouldOpportunisticallyEmitVTables())
+      SkippedVTables.erase(RD);
+    } else if (shouldOpportunisticallyEmitVTables()) {
       OpportunisticVTables.push_back(RD);
+    }
 
   assert(savedSize == DeferredVTables.size() &&
          "deferred extra vtables during vtable emission?");
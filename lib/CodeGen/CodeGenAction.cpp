@@ -825,6 +825,13 @@ llvm::LLVMContext *CodeGenAction::takeLLVMContext() {
 
 static std::unique_ptr<raw_pwrite_stream>
 GetOutputStream(CompilerInstance &CI, StringRef InFile, BackendAction Action) {
+  // With -fparallel-codegen, each partition is written to its own
+  // -parallel-codegen-output file instead. CompilerInvocation rejects the
+  // option for the pipelines that don't write partitions.
+  if (CI.getCodeGenOpts().ParallelCodeGen > 1 &&
+      (Action == Backend_EmitAssembly || Action == Backend_EmitObj))
+    return CI.createNullOutputFile();
+
   switch (Action) {
   case Backend_EmitAssembly:
     return CI.createDefaultOutputFile(false, InFile, "s");
@@ -43,6 +43,7 @@
 #include "clang/Basic/Version.h"
 #include "clang/CodeGen/ConstantInitBuilder.h"
 #include "clang/Frontend/CodeGenOptions.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Sema/SemaDiagnostic.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
@@ -52,9 +53,12 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ProfileSummary.h"
 #include "llvm/ProfileData/InstrProfReader.h"
+#include "llvm/ProfileData/InstrProfWriter.h"
 #include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MD5.h"
 
 using namespace clang;
@@ -150,19 +154,8 @@ CodeGenModule::CodeGenModule(ASTContext &C, const HeaderSearchOptions &HSO,
   if (C.getLangOpts().ObjC1)
     ObjCData.reset(new ObjCEntrypoints());
 
-  if (CodeGenOpts.hasProfileClangUse()) {
-    auto ReaderOrErr = llvm::IndexedInstrProfReader::create(
-        CodeGenOpts.ProfileInstrumentUsePath);
-    if (auto E = ReaderOrErr.takeError()) {
-      unsigned DiagID = Diags.getCustomDiagID(DiagnosticsEngine::Error,
-                                              "Could not read profile %0: %1");
-      llvm::handleAllErrors(std::move(E), [&](const llvm::ErrorInfoBase &EI) {
-        getDiags().Report(DiagID) << CodeGenOpts.ProfileInstrumentUsePath
-                                  << EI.message();
-      });
-    } else
-      PGOReader = std::move(ReaderOrErr.get());
-  }
+  if (CodeGenOpts.hasProfileClangUse())
+    loadPGOProfile();
 
   // If coverage mapping generation is enabled, create the
   // CoverageMappingModuleGen object.
@@ -172,6 +165,235 @@ CodeGenModule::CodeGenModule(ASTContext &C, const HeaderSearchOptions &HSO,
 
 CodeGenModule::~CodeGenModule() {}
 
+std::unique_ptr<llvm::IndexedInstrProfReader>
+CodeGenModule::createPGOReader(StringRef Path) {
+  // Indexed profiles of large programs can be hundreds of megabytes, of which
+  // a single translation unit looks up a handful of records. Don't require a
+  // null terminator so that the buffer is always mapped rather than read, and
+  // only the pages of the hash table buckets actually probed are faulted in.
+  auto BufferOrErr = llvm::MemoryBuffer::getFile(
+      Path, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  llvm::Expected<std::unique_ptr<llvm::IndexedInstrProfReader>> ReaderOrErr =
+      BufferOrErr ? llvm::IndexedInstrProfReader::create(
+                        std::move(BufferOrErr.get()))
+                  : llvm::errorCodeToError(BufferOrErr.getError());
+  if (auto E = ReaderOrErr.takeError()) {
+    unsigned DiagID = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                                            "Could not read profile %0: %1");
+    llvm::handleAllErrors(std::move(E), [&](const llvm::ErrorInfoBase &EI) {
+      getDiags().Report(DiagID) << Path << EI.message();
+    });
+    return nullptr;
+  }
+  return std::move(ReaderOrErr.get());
+}
+
+/// The name of the record in a profile subset that identifies the full
+/// profile it was taken from. Its hash is the version of the record's layout,
+/// and its counts are, in order:
+///   the size and modification time of the full profile,
+///   the version of the full profile,
+///   the total, maximum, maximum internal and maximum function counts, the
+///   number of counts and functions, and the number of entries of its
+///   summary, followed by the cutoff, minimum count and number of counts of
+///   each entry,
+///   the number of failed lookups, followed by the MD5 hash of the function
+///   name, the function hash and the instrprof_error of each.
+static const char PGOSubsetSourceName[] = "__clang_profile_subset_source";
+static const uint64_t PGOSubsetSourceLayout = 1;
+
+void CodeGenModule::loadPGOProfile() {
+  const std::string &Path = CodeGenOpts.ProfileInstrumentUsePath;
+  llvm::sys::fs::file_status Status;
+  bool KnowProfile = !llvm::sys::fs::status(Path, Status);
+  if (KnowProfile) {
+    PGOProfileSize = Status.getSize();
+    PGOProfileModTime = llvm::sys::toTimeT(Status.getLastModificationTime());
+  }
+
+  // An up-to-date subset has everything this translation unit needed the
+  // last time it was compiled, so the full profile, which may be huge, is
+  // only opened if a lookup goes beyond that. A stale subset is not used at
+  // all, since its records may no longer match the full profile.
+  if (!CodeGenOpts.ProfileInstrumentUseSubsetPath.empty()) {
+    PGOSubsetReader =
+        createPGOReader(CodeGenOpts.ProfileInstrumentUseSubsetPath);
+    if (!PGOSubsetReader)
+      return;
+    if (!KnowProfile || !readPGOSubsetSource())
+      PGOSubsetReader.reset();
+  }
+
+  if (!PGOSubsetReader) {
+    if (!openFullPGOProfile())
+      return;
+    PGOProfileVersion = PGOReader->getVersion();
+    PGOProfileSummary =
+        llvm::make_unique<llvm::ProfileSummary>(PGOReader->getSummary());
+  }
+
+  HasPGOProfile = true;
+  if (!CodeGenOpts.ProfileInstrumentSubsetOutput.empty())
+    PGOSubsetWriter = llvm::make_unique<llvm::InstrProfWriter>();
+}
+
+bool CodeGenModule::openFullPGOProfile() {
+  if (!PGOReader && !TriedOpeningPGOReader) {
+    TriedOpeningPGOReader = true;
+    PGOReader = createPGOReader(CodeGenOpts.ProfileInstrumentUsePath);
+  }
+  return PGOReader != nullptr;
+}
+
+bool CodeGenModule::readPGOSubsetSource() {
+  llvm::Expected<llvm::InstrProfRecord> SourceOrErr =
+      PGOSubsetReader->getInstrProfRecord(PGOSubsetSourceName,
+                                          PGOSubsetSourceLayout);
+  if (!SourceOrErr) {
+    llvm::consumeError(SourceOrErr.takeError());
+    return false;
+  }
+
+  ArrayRef<uint64_t> Counts = SourceOrErr->Counts;
+  auto Next = [&Counts](uint64_t &Value) {
+    if (Counts.empty())
+      return false;
+    Value = Counts.front();
+    Counts = Counts.drop_front();
+    return true;
+  };
+
+  uint64_t Size, ModTime, Version;
+  if (!Next(Size) || !Next(ModTime) || !Next(Version) ||
+      Size != PGOProfileSize || ModTime != PGOProfileModTime)
+    return false;
+
+  uint64_t TotalCount, MaxCount, MaxInternalCount, MaxFunctionCount,
+      NumCounts, NumFunctions, NumEntries;
+  if (!Next(TotalCount) || !Next(MaxCount) || !Next(MaxInternalCount) ||
+      !Next(MaxFunctionCount) || !Next(NumCounts) || !Next(NumFunctions) ||
+      !Next(NumEntries))
+    return false;
+  llvm::SummaryEntryVector Entries;
+  for (uint64_t I = 0; I != NumEntries; ++I) {
+    uint64_t Cutoff, MinCount, EntryNumCounts;
+    if (!Next(Cutoff) || !Next(MinCount) || !Next(EntryNumCounts))
+      return false;
+    Entries.emplace_back(Cutoff, MinCount, EntryNumCounts);
+  }
+
+  uint64_t NumMisses;
+  if (!Next(NumMisses))
+    return false;
+  PGOMissMap Misses;
+  for (uint64_t I = 0; I != NumMisses; ++I) {
+    uint64_t NameHash, FuncHash, Error;
+    if (!Next(NameHash) || !Next(FuncHash) || !Next(Error))
+      return false;
+    Misses[{NameHash, FuncHash}] = Error;
+  }
+
+  PGOProfileVersion = Version;
+  PGOProfileSummary = llvm::make_unique<llvm::ProfileSummary>(
+      llvm::ProfileSummary::PSK_Instr, std::move(Entries), TotalCount,
+      MaxCount, MaxInternalCount, MaxFunctionCount, NumCounts, NumFunctions);
+  PGOSubsetMisses = std::move(Misses);
+  return true;
+}
+
+llvm::Expected<llvm::InstrProfRecord>
+CodeGenModule::getPGORecord(StringRef FuncName, uint64_t FuncHash) {
+  assert(HasPGOProfile && "no profile to look up records in");
+  std::pair<uint64_t, uint64_t> Key(llvm::MD5Hash(FuncName), FuncHash);
+  auto Lookup = [&]() -> llvm::Expected<llvm::InstrProfRecord> {
+    if (!PGOSubsetReader)
+      return PGOReader->getInstrProfRecord(FuncName, FuncHash);
+
+    llvm::Expected<llvm::InstrProfRecord> RecordOrErr =
+        PGOSubsetReader->getInstrProfRecord(FuncName, FuncHash);
+    if (RecordOrErr)
+      return RecordOrErr;
+    llvm::consumeError(RecordOrErr.takeError());
+
+    // Records missing from the subset are looked up in the full profile,
+    // unless the subset knows that the lookup already failed there.
+    auto Miss = PGOSubsetMisses.find(Key);
+    if (Miss != PGOSubsetMisses.end())
+      return llvm::make_error<llvm::InstrProfError>(
+          static_cast<llvm::instrprof_error>(Miss->second));
+    if (!openFullPGOProfile())
+      return llvm::make_error<llvm::InstrProfError>(
+          llvm::instrprof_error::unknown_function);
+    return PGOReader->getInstrProfRecord(FuncName, FuncHash);
+  };
+  llvm::Expected<llvm::InstrProfRecord> RecordOrErr = Lookup();
+
+  if (!PGOSubsetWriter)
+    return RecordOrErr;
+
+  if (!RecordOrErr) {
+    llvm::instrprof_error Error =
+        llvm::InstrProfError::take(RecordOrErr.takeError());
+    PGONewMisses[Key] = static_cast<unsigned>(Error);
+    return llvm::make_error<llvm::InstrProfError>(Error);
+  }
+  llvm::NamedInstrProfRecord Record(FuncName, FuncHash, {});
+  static_cast<llvm::InstrProfRecord &>(Record) = *RecordOrErr;
+  PGOSubsetWriter->addRecord(std::move(Record), [](llvm::Error E) {
+    llvm::consumeError(std::move(E));
+  });
+  return RecordOrErr;
+}
+
+void CodeGenModule::writePGOSubset() {
+  // Identify the full profile, so that the subset is not used once the full
+  // profile changes.
+  std::vector<uint64_t> Source = {PGOProfileSize, PGOProfileModTime,
+                                  PGOProfileVersion};
+  llvm::ProfileSummary &Summary = *PGOProfileSummary;
+  Source.insert(Source.end(),
+                {Summary.getTotalCount(), Summary.getMaxCount(),
+                 Summary.getMaxInternalCount(), Summary.getMaxFunctionCount(),
+                 Summary.getNumCounts(), Summary.getNumFunctions(),
+                 Summary.getDetailedSummary().size()});
+  for (const llvm::ProfileSummaryEntry &Entry : Summary.getDetailedSummary())
+    Source.insert(Source.end(),
+                  {Entry.Cutoff, Entry.MinCount, Entry.NumCounts});
+  Source.push_back(PGONewMisses.size());
+  for (const auto &Miss : PGONewMisses)
+    Source.insert(Source.end(),
+                  {Miss.first.first, Miss.first.second, Miss.second});
+  PGOSubsetWriter->addRecord(
+      llvm::NamedInstrProfRecord(PGOSubsetSourceName, PGOSubsetSourceLayout,
+                                 std::move(Source)),
+      [](llvm::Error E) { llvm::consumeError(std::move(E)); });
+
+  // Parallel compilations may share the output, so write it to a temporary
+  // file and rename that into place, so that readers never see a partial
+  // profile.
+  const std::string &Path = CodeGenOpts.ProfileInstrumentSubsetOutput;
+  SmallString<128> TempPath;
+  int FD;
+  std::error_code EC =
+      llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath);
+  if (!EC) {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    PGOSubsetWriter->write(OS);
+    OS.close();
+    EC = OS.error();
+    OS.clear_error();
+    if (!EC)
+      EC = llvm::sys::fs::rename(TempPath, Path);
+    if (EC)
+      llvm::sys::fs::remove(TempPath);
+  }
+  if (EC) {
+    unsigned DiagID = Diags.getCustomDiagID(
+        DiagnosticsEngine::Error, "Could not write profile subset %0: %1");
+    getDiags().Report(DiagID) << Path << EC.message();
+  }
+}
+
 void CodeGenModule::createObjCRuntime() {
   // This is just isGNUFamily(), but we want to force implementors of
   // new ABIs to decide how best to do this.
@@ -390,6 +612,13 @@ void InstrProfStats::reportDiagnostics(DiagnosticsEngine &Diags,
 
 void CodeGenModule::Release() {
   EmitDeferred();
+  if (shouldPruneDeferredDecls()) {
+    EmitPostponedDeferredDecls();
+    if (!SkippedVTables.empty() || !PostponedDeferredDecls.empty())
+      getDiags().Report(diag::remark_pruned_deferred_decls)
+          << (unsigned)SkippedVTables.size()
+          << (unsigned)PostponedDeferredDecls.size();
+  }
   EmitVTablesOpportunistically();
   applyGlobalValReplacements();
   applyReplacements();
@@ -418,8 +647,12 @@ void CodeGenModule::Release() {
     }
     OpenMPRuntime->clear();
   }
-  if (PGOReader) {
-    getModule().setProfileSummary(PGOReader->getSummary().getMD(VMContext));
+  if (HasPGOProfile) {
+    // The summary describes the whole program, so always take it from the full
+    // profile rather than from the records of the subset.
+    getModule().setProfileSummary(PGOProfileSummary->getMD(VMContext));
+    if (PGOSubsetWriter)
+      writePGOSubset();
     if (PGOStats.hasDiagnostics())
       PGOStats.reportDiagnostics(getDiags(), getCodeGenOpts().MainFileName);
   }
@@ -1710,6 +1943,23 @@ void CodeGenModule::EmitDeferred() {
     if (!GV->isDeclaration())
       continue;
 
+    // A decl can be queued by a reference that does not survive, such as one
+    // from a constant that was built speculatively and then dropped. Hold off
+    // on those until something uses them. Multiversion functions are only
+    // referenced by their resolvers, which are emitted after this. Decls that
+    // must be emitted anyway, such as 'used' implicit instantiations, are
+    // only deferred because they cannot be emitted eagerly.
+    const auto *FD = dyn_cast<FunctionDecl>(D.getDecl());
+    const auto *VD = dyn_cast<ValueDecl>(D.getDecl());
+    if (shouldPruneDeferredDecls() && !(FD && FD->isMultiVersion()) &&
+        !(VD && MustBeEmitted(VD))) {
+      GV->removeDeadConstantUsers();
+      if (GV->use_empty()) {
+        PostponedDeferredDecls.push_back(D);
+        continue;
+      }
+    }
+
     // Otherwise, emit the definition and move on to the next one.
     EmitGlobalDefinition(D, GV);
 
@@ -1723,6 +1973,38 @@ void CodeGenModule::EmitDeferred() {
   }
 }
 
+bool CodeGenModule::shouldPruneDeferredDecls() const {
+  // Runtimes that register functions at the end of the module, and kexts,
+  // which find vtables by name, can need definitions nothing references yet.
+  return CodeGenOpts.PruneDeferredDecls && LangOpts.CPlusPlus &&
+         !LangOpts.CUDA && !LangOpts.OpenMP && !LangOpts.AppleKext;
+}
+
+void CodeGenModule::EmitPostponedDeferredDecls() {
+  while (true) {
+    std::vector<GlobalDecl> StillUnused;
+    for (GlobalDecl &D : PostponedDeferredDecls) {
+      llvm::GlobalValue *GV = GetGlobalValue(getMangledName(D));
+      if (GV && !GV->isDeclaration())
+        continue;
+      if (GV) {
+        GV->removeDeadConstantUsers();
+        if (!GV->use_empty()) {
+          addDeferredDeclToEmit(D);
+          continue;
+        }
+      }
+      StillUnused.push_back(D);
+    }
+    PostponedDeferredDecls.swap(StillUnused);
+
+    // Emitting the decls that became used may make more postponed ones used.
+    if (DeferredDeclsToEmit.empty())
+      return;
+    EmitDeferred();
+  }
+}
+
 void CodeGenModule::EmitVTablesOpportunistically() {
   // Try to emit external vtables as available_externally if they have emitted
   // all inlined virtual functions.  It runs after EmitDeferred() and therefore
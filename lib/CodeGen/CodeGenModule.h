@@ -35,6 +35,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Transforms/Utils/SanitizerStats.h"
 
 namespace llvm {
@@ -47,6 +48,9 @@ class DataLayout;
 class FunctionType;
 class LLVMContext;
 class IndexedInstrProfReader;
+class InstrProfRecord;
+class InstrProfWriter;
+class ProfileSummary;
 }
 
 namespace clang {
@@ -267,6 +271,14 @@ public:
 
   typedef std::vector<Structor> CtorList;
 
+  /// How a target builtin is lowered: the LLVM intrinsic it maps to
+  /// one-to-one, if any, and the mask of its arguments that must be integer
+  /// constant expressions.
+  struct BuiltinLoweringInfo {
+    unsigned IntrinsicID;
+    unsigned ICEArguments;
+  };
+
 private:
   ASTContext &Context;
   const LangOptions &LangOpts;
@@ -299,9 +311,39 @@ private:
   std::unique_ptr<ObjCEntrypoints> ObjCData;
   llvm::MDNode *NoObjCARCExceptionsMetadata = nullptr;
   std::unique_ptr<llvm::IndexedInstrProfReader> PGOReader;
+  std::unique_ptr<llvm::IndexedInstrProfReader> PGOSubsetReader;
+  std::unique_ptr<llvm::InstrProfWriter> PGOSubsetWriter;
+
+  /// Whether function profiles are read, either from the full profile or
+  /// from a subset that is up to date with it.
+  bool HasPGOProfile = false;
+
+  /// Whether opening the full profile was attempted. It is opened lazily
+  /// when an up-to-date subset is read.
+  bool TriedOpeningPGOReader = false;
+
+  /// The size and modification time of the full profile, which identify it
+  /// in the subsets taken from it.
+  uint64_t PGOProfileSize = 0;
+  uint64_t PGOProfileModTime = 0;
+
+  /// The version and summary of the full profile. They describe the whole
+  /// program, so an up-to-date subset carries a copy of them.
+  uint64_t PGOProfileVersion = 0;
+  std::unique_ptr<llvm::ProfileSummary> PGOProfileSummary;
+
+  /// Lookups that failed in the full profile, keyed by the MD5 hash of the
+  /// function name and the function hash: those recorded in the subset
+  /// that is read, and those made by this translation unit.
+  using PGOMissMap = llvm::DenseMap<std::pair<uint64_t, uint64_t>, unsigned>;
+  PGOMissMap PGOSubsetMisses;
+  PGOMissMap PGONewMisses;
   InstrProfStats PGOStats;
   std::unique_ptr<llvm::SanitizerStatReport> SanStats;
 
+  /// Cache of getBuiltinLoweringInfo, keyed by builtin ID.
+  llvm::DenseMap<unsigned, BuiltinLoweringInfo> BuiltinLowerings;
+
   // A set of references that have only been seen via a weakref so far. This is
   // used to remove the weak of the reference if we ever see a direct reference
   // or a definition.
@@ -348,6 +390,14 @@ private:
   /// A queue of (optional) vtables that may be emitted opportunistically.
   std::vector<const CXXRecordDecl *> OpportunisticVTables;
 
+  /// Vtables that Sema asked for but that were not emitted because nothing
+  /// referenced them yet, with -fprune-deferred-decls.
+  llvm::SmallPtrSet<const CXXRecordDecl *, 16> SkippedVTables;
+
+  /// Deferred decls whose definitions were not emitted because nothing used
+  /// them anymore, with -fprune-deferred-decls.
+  std::vector<GlobalDecl> PostponedDeferredDecls;
+
   /// List of global values which are required to be present in the object file;
   /// bitcast to i8*. This is used for forcing visibility of symbols which may
   /// otherwise be optimized out.
@@ -559,7 +609,17 @@ public:
   llvm::Constant *IsOSVersionAtLeastFn = nullptr;
 
   InstrProfStats &getPGOStats() { return PGOStats; }
-  llvm::IndexedInstrProfReader *getPGOReader() const { return PGOReader.get(); }
+
+  /// Whether function profiles are read with -fprofile-instrument-use-path.
+  bool hasPGOProfile() const { return HasPGOProfile; }
+
+  /// The version of the profile read with -fprofile-instrument-use-path.
+  uint64_t getPGOProfileVersion() const { return PGOProfileVersion; }
+
+  /// Look up the profile record of a function, in the profile subset first if
+  /// there is one, and remember it for -fprofile-instrument-subset-output.
+  llvm::Expected<llvm::InstrProfRecord> getPGORecord(StringRef FuncName,
+                                                     uint64_t FuncHash);
 
   CoverageMappingModuleGen *getCoverageMapping() const {
     return CoverageMapping.get();
@@ -930,6 +990,10 @@ public:
                        bool DontDefer = false,
                        ForDefinition_t IsForDefinition = NotForDefinition);
 
+  /// Return how the builtin \p BuiltinID is lowered, computing it on first
+  /// use.
+  BuiltinLoweringInfo getBuiltinLoweringInfo(unsigned BuiltinID);
+
   /// Given a builtin id for a function like "__builtin_fabsf", return a
   /// Function* for "fabsf".
   llvm::Constant *getBuiltinLibFunction(const FunctionDecl *FD,
@@ -1333,6 +1397,14 @@ private:
   /// Emit any needed decls for which code generation was deferred.
   void EmitDeferred();
 
+  /// Whether vtables and deferred definitions that may be discarded are only
+  /// emitted once emitted code uses them.
+  bool shouldPruneDeferredDecls() const;
+
+  /// Emit the postponed deferred decls that became used while emitting other
+  /// deferred decls, until no more do.
+  void EmitPostponedDeferredDecls();
+
   /// Try to emit external vtables as available_externally if they have emitted
   /// all inlined virtual functions.  It runs after EmitDeferred() and therefore
   /// is not allowed to create new references to things that need to be emitted
@@ -1372,6 +1444,26 @@ private:
   /// linkage specifications, giving them the "expected" name where possible.
   void EmitStaticExternCAliases();
 
+  /// Open the indexed profile at \p Path, diagnosing any failure.
+  std::unique_ptr<llvm::IndexedInstrProfReader>
+  createPGOReader(StringRef Path);
+
+  /// Set up the profile named by -fprofile-instrument-use-path, preferring
+  /// an up-to-date subset of it.
+  void loadPGOProfile();
+
+  /// Open the full profile, the first time it is needed.
+  bool openFullPGOProfile();
+
+  /// Whether the subset being read was taken from the current full profile.
+  /// If so, read the version, summary and failed lookups of the full profile
+  /// from it.
+  bool readPGOSubsetSource();
+
+  /// Write the profile records looked up so far to the file named by
+  /// -fprofile-instrument-subset-output.
+  void writePGOSubset();
+
   void EmitDeclMetadata();
 
   /// Emit the Clang version as llvm.ident metadata.
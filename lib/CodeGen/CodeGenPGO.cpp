@@ -32,10 +32,10 @@ using namespace CodeGen;
 
 void CodeGenPGO::setFuncName(StringRef Name,
                              llvm::GlobalValue::LinkageTypes Linkage) {
-  llvm::IndexedInstrProfReader *PGOReader = CGM.getPGOReader();
   FuncName = llvm::getPGOFuncName(
       Name, Linkage, CGM.getCodeGenOpts().MainFileName,
-      PGOReader ? PGOReader->getVersion() : llvm::IndexedInstrProf::Version);
+      CGM.hasPGOProfile() ? CGM.getPGOProfileVersion()
+                          : llvm::IndexedInstrProf::Version);
 
   // If we're generating a profile, create a variable for the name.
   if (CGM.getCodeGenOpts().hasProfileClangInstr())
@@ -140,9 +140,8 @@ const unsigned PGOHash::NumTypesPerWord;
 const unsigned PGOHash::TooBig;
 
 /// Get the PGO hash version used in the given indexed profile.
-static PGOHashVersion getPGOHashVersion(llvm::IndexedInstrProfReader *PGOReader,
-                                        CodeGenModule &CGM) {
-  if (PGOReader->getVersion() <= 4)
+static PGOHashVersion getPGOHashVersion(CodeGenModule &CGM) {
+  if (CGM.getPGOProfileVersion() <= 4)
     return PGO_HASH_V1;
   return PGO_HASH_V2;
 }
@@ -756,8 +755,8 @@ void CodeGenPGO::assignRegionCounters(GlobalDecl GD, llvm::Function *Fn) {
     return;
 
   bool InstrumentRegions = CGM.getCodeGenOpts().hasProfileClangInstr();
-  llvm::IndexedInstrProfReader *PGOReader = CGM.getPGOReader();
-  if (!InstrumentRegions && !PGOReader)
+  bool UseProfile = CGM.hasPGOProfile();
+  if (!InstrumentRegions && !UseProfile)
     return;
   if (D->isImplicit())
     return;
@@ -779,11 +778,11 @@ void CodeGenPGO::assignRegionCounters(GlobalDecl GD, llvm::Function *Fn) {
   mapRegionCounters(D);
   if (CGM.getCodeGenOpts().CoverageMapping)
     emitCounterRegionMapping(D);
-  if (PGOReader) {
+  if (UseProfile) {
     SourceManager &SM = CGM.getContext().getSourceManager();
-    loadRegionCounts(PGOReader, SM.isInMainFile(D->getLocation()));
+    loadRegionCounts(SM.isInMainFile(D->getLocation()));
     computeRegionCounts(D);
-    applyFunctionAttributes(PGOReader, Fn);
+    applyFunctionAttributes(Fn);
   }
 }
 
@@ -791,8 +790,8 @@ void CodeGenPGO::mapRegionCounters(const Decl *D) {
   // Use the latest hash version when inserting instrumentation, but use the
   // version in the indexed profile if we're reading PGO data.
   PGOHashVersion HashVersion = PGO_HASH_LATEST;
-  if (auto *PGOReader = CGM.getPGOReader())
-    HashVersion = getPGOHashVersion(PGOReader, CGM);
+  if (CGM.hasPGOProfile())
+    HashVersion = getPGOHashVersion(CGM);
 
   RegionCounterMap.reset(new llvm::DenseMap<const Stmt *, unsigned>);
   MapRegionCounters Walker(HashVersion, *RegionCounterMap);
@@ -873,9 +872,7 @@ void CodeGenPGO::computeRegionCounts(const Decl *D) {
     Walker.VisitCapturedDecl(const_cast<CapturedDecl *>(CD));
 }
 
-void
-CodeGenPGO::applyFunctionAttributes(llvm::IndexedInstrProfReader *PGOReader,
-                                    llvm::Function *Fn) {
+void CodeGenPGO::applyFunctionAttributes(llvm::Function *Fn) {
   if (!haveRegionCounts())
     return;
 
@@ -937,8 +934,7 @@ void CodeGenPGO::valueProfile(CGBuilderTy &Builder, uint32_t ValueKind,
     return;
   }
 
-  llvm::IndexedInstrProfReader *PGOReader = CGM.getPGOReader();
-  if (PGOReader && haveRegionCounts()) {
+  if (CGM.hasPGOProfile() && haveRegionCounts()) {
     // We record the top most called three functions at each call site.
     // Profile metadata contains "VP" string identifying this metadata
     // as value profiling data, then a uint32_t value for the value profiling
@@ -956,12 +952,11 @@ void CodeGenPGO::valueProfile(CGBuilderTy &Builder, uint32_t ValueKind,
   }
 }
 
-void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
-                                  bool IsInMainFile) {
+void CodeGenPGO::loadRegionCounts(bool IsInMainFile) {
   CGM.getPGOStats().addVisited(IsInMainFile);
   RegionCounts.clear();
   llvm::Expected<llvm::InstrProfRecord> RecordExpected =
-      PGOReader->getInstrProfRecord(FuncName, FunctionHash);
+      CGM.getPGORecord(FuncName, FunctionHash);
   if (auto E = RecordExpected.takeError()) {
     auto IPE = llvm::InstrProfError::take(std::move(E));
     if (IPE == llvm::instrprof_error::unknown_function)
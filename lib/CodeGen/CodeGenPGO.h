@@ -94,10 +94,8 @@ private:
   void setFuncName(StringRef Name, llvm::GlobalValue::LinkageTypes Linkage);
   void mapRegionCounters(const Decl *D);
   void computeRegionCounts(const Decl *D);
-  void applyFunctionAttributes(llvm::IndexedInstrProfReader *PGOReader,
-                               llvm::Function *Fn);
-  void loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
-                        bool IsInMainFile);
+  void applyFunctionAttributes(llvm::Function *Fn);
+  void loadRegionCounts(bool IsInMainFile);
   bool skipRegionMappingForDecl(const Decl *D);
   void emitCounterRegionMapping(const Decl *D);
 
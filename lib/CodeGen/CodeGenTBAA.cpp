@@ -27,6 +27,8 @@
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -77,6 +79,30 @@ llvm::MDNode *CodeGenTBAA::getChar() {
   return Char;
 }
 
+void CodeGenTBAA::mangleTypeNodeName(QualType QTy,
+                                     SmallVectorImpl<char> &OutName) {
+  llvm::raw_svector_ostream Out(OutName);
+  if (!CodeGenOpts.HashTBAATypeNames) {
+    MContext.mangleTypeName(QTy, Out);
+    return;
+  }
+
+  // Mangled names of template specializations can get very long, and every
+  // module that mentions the type carries a copy of the name that the IR
+  // linker has to unique again. Since the mangled name identifies the type
+  // program-wide, a fixed-size hash of it does so as well. A collision can
+  // only make two distinct types look alike, which is conservative.
+  SmallString<256> MangledName;
+  llvm::raw_svector_ostream MangledOut(MangledName);
+  MContext.mangleTypeName(QTy, MangledOut);
+
+  llvm::MD5 Hash;
+  llvm::MD5::MD5Result Result;
+  Hash.update(MangledName);
+  Hash.final(Result);
+  Out << "tbaa." << llvm::format_hex_no_prefix(Result.low(), 16);
+}
+
 static bool TypeHasMayAlias(QualType QTy) {
   // Tagged types have declarations, and therefore may have attributes.
   if (const TagType *TTy = dyn_cast<TagType>(QTy))
@@ -176,8 +202,7 @@ llvm::MDNode *CodeGenTBAA::getTypeInfoHelper(const Type *Ty) {
       return getChar();
 
     SmallString<256> OutName;
-    llvm::raw_svector_ostream Out(OutName);
-    MContext.mangleTypeName(QualType(ETy, 0), Out);
+    mangleTypeNodeName(QualType(ETy, 0), OutName);
     return createScalarTypeNode(OutName, getChar(), Size);
   }
 
@@ -229,7 +254,7 @@ TBAAAccessInfo CodeGenTBAA::getAccessInfo(QualType AccessType) {
 }
 
 TBAAAccessInfo CodeGenTBAA::getVTablePtrAccessInfo(llvm::Type *VTablePtrType) {
-  llvm::DataLayout DL(&Module);
+  const llvm::DataLayout &DL = Module.getDataLayout();
   unsigned Size = DL.getPointerTypeSize(VTablePtrType);
   return TBAAAccessInfo(createScalarTypeNode("vtable pointer", getRoot(), Size),
                         Size);
@@ -281,15 +306,17 @@ llvm::MDNode *
 CodeGenTBAA::getTBAAStructInfo(QualType QTy) {
   const Type *Ty = Context.getCanonicalType(QTy).getTypePtr();
 
-  if (llvm::MDNode *N = StructMetadataCache[Ty])
-    return N;
+  auto It = StructMetadataCache.find(Ty);
+  if (It != StructMetadataCache.end())
+    return It->second;
 
+  llvm::MDNode *StructNode = nullptr;
   SmallVector<llvm::MDBuilder::TBAAStructField, 4> Fields;
   if (CollectFields(0, QTy, Fields, TypeHasMayAlias(QTy)))
-    return MDHelper.createTBAAStructNode(Fields);
+    StructNode = MDHelper.createTBAAStructNode(Fields);
 
   // For now, handle any other kind of type conservatively.
-  return StructMetadataCache[Ty] = nullptr;
+  return StructMetadataCache[Ty] = StructNode;
 }
 
 llvm::MDNode *CodeGenTBAA::getBaseTypeInfoHelper(const Type *Ty) {
@@ -314,8 +341,7 @@ llvm::MDNode *CodeGenTBAA::getBaseTypeInfoHelper(const Type *Ty) {
     SmallString<256> OutName;
     if (Features.CPlusPlus) {
       // Don't use the mangler for C code.
-      llvm::raw_svector_ostream Out(OutName);
-      MContext.mangleTypeName(QualType(Ty, 0), Out);
+      mangleTypeNodeName(QualType(Ty, 0), OutName);
     } else {
       OutName = RD->getName();
     }
@@ -160,6 +160,10 @@ class CodeGenTBAA {
   llvm::MDNode *createScalarTypeNode(StringRef Name, llvm::MDNode *Parent,
                                      uint64_t Size);
 
+  /// mangleTypeNodeName - Produce the identifier of the type node describing
+  /// the given C++ type with linkage.
+  void mangleTypeNodeName(QualType QTy, SmallVectorImpl<char> &OutName);
+
   /// getTypeInfoHelper - An internal helper function to generate metadata used
   /// to describe accesses to objects of the given type.
   llvm::MDNode *getTypeInfoHelper(const Type *Ty);
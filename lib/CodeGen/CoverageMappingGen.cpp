@@ -30,7 +30,16 @@ using namespace CodeGen;
 using namespace llvm::coverage;
 
 void CoverageSourceInfo::SourceRangeSkipped(SourceRange Range, SourceLocation) {
-  SkippedRanges.push_back(Range);
+  // The preprocessor reports ranges in order, so this is almost always an
+  // append. Keeping them sorted lets each function find its ranges quickly.
+  auto Pos = SkippedRanges.end();
+  if (!SkippedRanges.empty() &&
+      Range.getBegin() < SkippedRanges.back().getBegin())
+    Pos = std::upper_bound(SkippedRanges.begin(), SkippedRanges.end(), Range,
+                           [](const SourceRange &LHS, const SourceRange &RHS) {
+                             return LHS.getBegin() < RHS.getBegin();
+                           });
+  SkippedRanges.insert(Pos, Range);
 }
 
 namespace {
@@ -284,24 +293,39 @@ public:
           std::max(FileLineRanges[R.FileID].second, R.LineEnd);
     }
 
+    // The skipped ranges are sorted and the locations of a file are
+    // contiguous, so only look at the ranges in the files of this function
+    // rather than at every range in the translation unit.
     auto SkippedRanges = CVM.getSourceInfo().getSkippedRanges();
-    for (const auto &I : SkippedRanges) {
-      auto LocStart = I.getBegin();
-      auto LocEnd = I.getEnd();
-      assert(SM.isWrittenInSameFile(LocStart, LocEnd) &&
-             "region spans multiple files");
-
-      auto CovFileID = getCoverageFileID(LocStart);
-      if (!CovFileID)
+    for (const auto &Mapping : FileIDMapping) {
+      FileID File = Mapping.first;
+      if (!SM.getSLocEntry(File).isFile())
         continue;
-      SpellingRegion SR{SM, LocStart, LocEnd};
-      auto Region = CounterMappingRegion::makeSkipped(
-          *CovFileID, SR.LineStart, SR.ColumnStart, SR.LineEnd, SR.ColumnEnd);
-      // Make sure that we only collect the regions that are inside
-      // the source code of this function.
-      if (Region.LineStart >= FileLineRanges[*CovFileID].first &&
-          Region.LineEnd <= FileLineRanges[*CovFileID].second)
-        MappingRegions.push_back(Region);
+      unsigned CovFileID = Mapping.second.first;
+      SourceLocation FileStart = SM.getLocForStartOfFile(File);
+      SourceLocation FileEnd =
+          FileStart.getLocWithOffset(SM.getFileIDSize(File));
+
+      auto I = std::lower_bound(
+          SkippedRanges.begin(), SkippedRanges.end(), FileStart,
+          [](const SourceRange &R, SourceLocation Loc) {
+            return R.getBegin() < Loc;
+          });
+      for (; I != SkippedRanges.end() && !(FileEnd < I->getBegin()); ++I) {
+        auto LocStart = I->getBegin();
+        auto LocEnd = I->getEnd();
+        assert(SM.isWrittenInSameFile(LocStart, LocEnd) &&
+               "region spans multiple files");
+
+        SpellingRegion SR{SM, LocStart, LocEnd};
+        auto Region = CounterMappingRegion::makeSkipped(
+            CovFileID, SR.LineStart, SR.ColumnStart, SR.LineEnd, SR.ColumnEnd);
+        // Make sure that we only collect the regions that are inside
+        // the source code of this function.
+        if (Region.LineStart >= FileLineRanges[CovFileID].first &&
+            Region.LineEnd <= FileLineRanges[CovFileID].second)
+          MappingRegions.push_back(Region);
+      }
     }
   }
 
@@ -1275,7 +1299,7 @@ static void dump(llvm::raw_ostream &OS, StringRef FunctionName,
 
 void CoverageMappingModuleGen::addFunctionMappingRecord(
     llvm::GlobalVariable *NamePtr, StringRef NameValue, uint64_t FuncHash,
-    const std::string &CoverageMapping, bool IsUsed) {
+    StringRef CoverageMapping, bool IsUsed) {
   llvm::LLVMContext &Ctx = CGM.getLLVMContext();
   if (!FunctionRecordTy) {
 #define COVMAP_FUNC_RECORD(Type, LLVMType, Name, Init) LLVMType,
@@ -1296,7 +1320,7 @@ void CoverageMappingModuleGen::addFunctionMappingRecord(
   if (!IsUsed)
     FunctionNames.push_back(
         llvm::ConstantExpr::getBitCast(NamePtr, llvm::Type::getInt8PtrTy(Ctx)));
-  CoverageMappings.push_back(CoverageMapping);
+  CoverageMappings.append(CoverageMapping.begin(), CoverageMapping.end());
 
   if (CGM.getCodeGenOpts().DumpCoverageMapping) {
     // Dump the coverage mapping data for this function by decoding the
@@ -1344,11 +1368,12 @@ void CoverageMappingModuleGen::emit() {
   std::string FilenamesAndCoverageMappings;
   llvm::raw_string_ostream OS(FilenamesAndCoverageMappings);
   CoverageFilenamesSectionWriter(FilenameRefs).write(OS);
-  std::string RawCoverageMappings =
-      llvm::join(CoverageMappings.begin(), CoverageMappings.end(), "");
-  OS << RawCoverageMappings;
-  size_t CoverageMappingSize = RawCoverageMappings.size();
+  OS << CoverageMappings;
+  size_t CoverageMappingSize = CoverageMappings.size();
   size_t FilenamesSize = OS.str().size() - CoverageMappingSize;
+  // The mappings have been copied; release them before building the
+  // constant, which makes yet another copy.
+  std::string().swap(CoverageMappings);
   // Append extra zeroes if necessary to ensure that the size of the filenames
   // and coverage mappings is a multiple of 8.
   if (size_t Rem = OS.str().size() % 8) {
@@ -35,6 +35,7 @@ class Stmt;
 /// is required by the coverage mapping generator and is obtained from
 /// the preprocessor.
 class CoverageSourceInfo : public PPCallbacks {
+  /// The skipped ranges, sorted by their start locations.
   std::vector<SourceRange> SkippedRanges;
 public:
   ArrayRef<SourceRange> getSkippedRanges() const { return SkippedRanges; }
@@ -55,7 +56,9 @@ class CoverageMappingModuleGen {
   std::vector<llvm::Constant *> FunctionRecords;
   std::vector<llvm::Constant *> FunctionNames;
   llvm::StructType *FunctionRecordTy;
-  std::vector<std::string> CoverageMappings;
+  /// The encoded mappings of all functions, concatenated in the order of
+  /// their function records.
+  std::string CoverageMappings;
 
 public:
   CoverageMappingModuleGen(CodeGenModule &CGM, CoverageSourceInfo &SourceInfo)
@@ -70,7 +73,7 @@ public:
   void addFunctionMappingRecord(llvm::GlobalVariable *FunctionName,
                                 StringRef FunctionNameValue,
                                 uint64_t FunctionHash,
-                                const std::string &CoverageMapping,
+                                StringRef CoverageMapping,
                                 bool IsUsed = true);
 
   /// Emit the coverage mapping data for a translation unit.
@@ -20,12 +20,16 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Index/USRGeneration.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
-#include <fstream>
 #include <sstream>
 
 namespace clang {
@@ -61,8 +65,156 @@ public:
 };
 
 static llvm::ManagedStatic<IndexErrorCategory> Category;
+
+/// The magic number at the start of the index files in the binary format. It
+/// is followed by the 32-bit offset of the buckets of the hash table.
+const char BinaryIndexMagic[] = {'C', 'T', 'U', 'I', 'D', 'X', '0', '1'};
+const size_t BinaryIndexHeaderSize = sizeof(BinaryIndexMagic) + 4;
+
+/// Trait used to generate the binary index as an on-disk hash table from
+/// USRs to filepaths.
+class BinaryIndexWriterTrait {
+public:
+  using key_type = StringRef;
+  using key_type_ref = StringRef;
+  using data_type = StringRef;
+  using data_type_ref = StringRef;
+  using hash_value_type = uint32_t;
+  using offset_type = uint32_t;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::djbHash(Key);
+  }
+
+  std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer LE(Out, little);
+    LE.write<uint32_t>(Key.size());
+    LE.write<uint32_t>(Data.size());
+    return std::make_pair(Key.size(), Data.size());
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref Key, offset_type) { Out << Key; }
+
+  void EmitData(raw_ostream &Out, key_type_ref, data_type_ref Data,
+                offset_type) {
+    Out << Data;
+  }
+};
+
+/// Trait used to read the binary index.
+class BinaryIndexReaderTrait {
+public:
+  using external_key_type = StringRef;
+  using internal_key_type = StringRef;
+  using data_type = StringRef;
+  using hash_value_type = uint32_t;
+  using offset_type = uint32_t;
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+
+  static hash_value_type ComputeHash(internal_key_type Key) {
+    return llvm::djbHash(Key);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type Key) { return Key; }
+
+  static external_key_type GetExternalKey(internal_key_type Key) { return Key; }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<uint32_t, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *D, offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+
+  static data_type ReadData(internal_key_type, const unsigned char *D,
+                            offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+};
+
+using BinaryIndexTable =
+    llvm::OnDiskIterableChainedHashTable<BinaryIndexReaderTrait>;
+
+/// Returns whether \p Buffer holds an index file in the binary format.
+bool isBinaryIndex(const llvm::MemoryBuffer &Buffer) {
+  StringRef Data = Buffer.getBuffer();
+  return Data.size() >= BinaryIndexHeaderSize &&
+         Data.startswith(StringRef(BinaryIndexMagic, sizeof(BinaryIndexMagic)));
+}
+
+/// Returns the hash table of an index file in the binary format, or null if
+/// it is corrupt.
+BinaryIndexTable *createBinaryIndexTable(const llvm::MemoryBuffer &Buffer) {
+  assert(isBinaryIndex(Buffer) && "Not an index file in the binary format");
+  StringRef Data = Buffer.getBuffer();
+
+  const auto *Base = reinterpret_cast<const unsigned char *>(Data.data());
+  uint32_t BucketOffset =
+      llvm::support::endian::read32le(Base + sizeof(BinaryIndexMagic));
+  if (BucketOffset < BinaryIndexHeaderSize || BucketOffset % 4 != 0 ||
+      uint64_t(BucketOffset) + 8 > Data.size())
+    return nullptr;
+
+  // The bucket count is followed by the entry count and the bucket offsets,
+  // all of which must be within the buffer. OnDiskChainedHashTable also
+  // requires a power of two.
+  uint32_t NumBuckets = llvm::support::endian::read32le(Base + BucketOffset);
+  if (NumBuckets == 0 || (NumBuckets & (NumBuckets - 1)) != 0 ||
+      NumBuckets > (Data.size() - BucketOffset - 8) / 4)
+    return nullptr;
+  return BinaryIndexTable::Create(Base + BucketOffset,
+                                  Base + BinaryIndexHeaderSize, Base);
+}
+
+std::string getASTFilePath(StringRef CrossTUDir, StringRef FileName) {
+  SmallString<256> FilePath = CrossTUDir;
+  llvm::sys::path::append(FilePath, FileName);
+  return FilePath.str();
+}
+
+/// Approximate the memory used by an ASTUnit loaded from an AST file.
+uint64_t getASTUnitMemory(const ASTUnit &Unit) {
+  const ASTContext &Ctx = Unit.getASTContext();
+  const SourceManager &SM = Unit.getSourceManager();
+  SourceManager::MemoryBufferSizes Buffers = SM.getMemoryBufferSizes();
+  return Ctx.getASTAllocatedMemory() + Ctx.getSideTableAllocatedMemory() +
+         SM.getDataStructureSizes() + Buffers.malloc_bytes +
+         Buffers.mmap_bytes;
+}
 } // end anonymous namespace
 
+/// An index file in the binary format, which is mapped into memory and
+/// looked up without loading it.
+class CrossTranslationUnitContext::BinaryIndex {
+public:
+  BinaryIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+              BinaryIndexTable *Table)
+      : Buffer(std::move(Buffer)), Table(Table) {}
+
+  /// Returns the name of the AST file containing the definition of the
+  /// function with the given USR, or an empty string if there is none.
+  StringRef lookup(StringRef LookupName) {
+    auto It = Table->find(LookupName);
+    if (It == Table->end())
+      return StringRef();
+    return *It;
+  }
+
+private:
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<BinaryIndexTable> Table;
+};
+
 char IndexError::ID;
 
 void IndexError::log(raw_ostream &OS) const {
@@ -75,26 +227,39 @@ std::error_code IndexError::convertToErrorCode() const {
 
 llvm::Expected<llvm::StringMap<std::string>>
 parseCrossTUIndex(StringRef IndexPath, StringRef CrossTUDir) {
-  std::ifstream ExternalFnMapFile(IndexPath);
-  if (!ExternalFnMapFile)
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+      llvm::MemoryBuffer::getFile(IndexPath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!BufferOrErr)
     return llvm::make_error<IndexError>(index_error_code::missing_index_file,
                                         IndexPath.str());
 
   llvm::StringMap<std::string> Result;
-  std::string Line;
+  if (isBinaryIndex(**BufferOrErr)) {
+    std::unique_ptr<BinaryIndexTable> Table{
+        createBinaryIndexTable(**BufferOrErr)};
+    if (!Table)
+      return llvm::make_error<IndexError>(
+          index_error_code::invalid_index_format, IndexPath.str());
+    for (auto It = Table->key_begin(), End = Table->key_end(); It != End;
+         ++It)
+      Result[*It] = getASTFilePath(CrossTUDir, *Table->find(*It));
+    return Result;
+  }
+
+  StringRef Rest = (*BufferOrErr)->getBuffer();
   unsigned LineNo = 1;
-  while (std::getline(ExternalFnMapFile, Line)) {
-    const size_t Pos = Line.find(" ");
-    if (Pos > 0 && Pos != std::string::npos) {
-      StringRef LineRef{Line};
+  while (!Rest.empty()) {
+    StringRef LineRef;
+    std::tie(LineRef, Rest) = Rest.split('\n');
+    const size_t Pos = LineRef.find(" ");
+    if (Pos > 0 && Pos != StringRef::npos) {
       StringRef FunctionLookupName = LineRef.substr(0, Pos);
       if (Result.count(FunctionLookupName))
         return llvm::make_error<IndexError>(
             index_error_code::multiple_definitions, IndexPath.str(), LineNo);
       StringRef FileName = LineRef.substr(Pos + 1);
-      SmallString<256> FilePath = CrossTUDir;
-      llvm::sys::path::append(FilePath, FileName);
-      Result[FunctionLookupName] = FilePath.str().str();
+      Result[FunctionLookupName] = getASTFilePath(CrossTUDir, FileName);
     } else
       return llvm::make_error<IndexError>(
           index_error_code::invalid_index_format, IndexPath.str(), LineNo);
@@ -111,6 +276,23 @@ createCrossTUIndexString(const llvm::StringMap<std::string> &Index) {
   return Result.str();
 }
 
+std::string
+createCrossTUBinaryIndex(const llvm::StringMap<std::string> &Index) {
+  llvm::OnDiskChainedHashTableGenerator<BinaryIndexWriterTrait> Generator;
+  for (const auto &E : Index)
+    Generator.insert(E.getKey(), E.getValue());
+
+  SmallString<4096> Buffer;
+  llvm::raw_svector_ostream Out(Buffer);
+  Out.write(BinaryIndexMagic, sizeof(BinaryIndexMagic));
+  // The offset of the buckets is filled in once the table is emitted.
+  llvm::support::endian::Writer(Out, llvm::support::little).write<uint32_t>(0);
+  uint32_t BucketOffset = Generator.Emit(Out);
+  llvm::support::endian::write32le(&Buffer[sizeof(BinaryIndexMagic)],
+                                   BucketOffset);
+  return Buffer.str();
+}
+
 CrossTranslationUnitContext::CrossTranslationUnitContext(CompilerInstance &CI)
     : CI(CI), Context(CI.getASTContext()) {}
 
@@ -167,10 +349,64 @@ CrossTranslationUnitContext::getCrossTUDefinition(const FunctionDecl *FD,
          &Unit->getASTContext().getSourceManager().getFileManager());
 
   TranslationUnitDecl *TU = Unit->getASTContext().getTranslationUnitDecl();
-  if (const FunctionDecl *ResultDecl =
-          findFunctionInDeclContext(TU, LookupFnName))
-    return importDefinition(ResultDecl);
-  return llvm::make_error<IndexError>(index_error_code::failed_import);
+  const FunctionDecl *ResultDecl = nullptr;
+  if (LazyDefinitionLookup)
+    ResultDecl = lookupFunctionByName(Unit->getASTContext(), FD, LookupFnName);
+  if (!ResultDecl)
+    ResultDecl = findFunctionInDeclContext(TU, LookupFnName);
+  if (!ResultDecl)
+    return llvm::make_error<IndexError>(index_error_code::failed_import);
+
+  llvm::Expected<const FunctionDecl *> Result = importDefinition(ResultDecl);
+  unloadASTUnits(Unit);
+  return Result;
+}
+
+/// Look up the definition of the function with the same name and declaration
+/// context as \p FD in another AST. Only the declarations with these names
+/// are deserialized. Returns null for the functions and contexts that can't
+/// be looked up by their identifier.
+const FunctionDecl *
+CrossTranslationUnitContext::lookupFunctionByName(ASTContext &From,
+                                                  const FunctionDecl *FD,
+                                                  StringRef LookupFnName) {
+  if (!FD->getIdentifier())
+    return nullptr;
+
+  SmallVector<const NamedDecl *, 4> Contexts;
+  for (const DeclContext *DC = FD->getDeclContext(); !DC->isTranslationUnit();
+       DC = DC->getParent()) {
+    if (DC->isTransparentContext())
+      continue;
+    const auto *ND = dyn_cast<NamedDecl>(DC);
+    if (!ND || !ND->getIdentifier() ||
+        !(isa<NamespaceDecl>(ND) || isa<RecordDecl>(ND)))
+      return nullptr;
+    Contexts.push_back(ND);
+  }
+
+  DeclContext *FromDC = From.getTranslationUnitDecl();
+  for (const NamedDecl *Context : llvm::reverse(Contexts)) {
+    DeclContext *Next = nullptr;
+    IdentifierInfo *Name = &From.Idents.get(Context->getName());
+    for (NamedDecl *Found : FromDC->lookup(Name))
+      if (Found->getKind() == Context->getKind()) {
+        Next = cast<DeclContext>(Found);
+        break;
+      }
+    if (!Next)
+      return nullptr;
+    FromDC = Next;
+  }
+
+  for (NamedDecl *Found : FromDC->lookup(&From.Idents.get(FD->getName()))) {
+    const auto *FoundFD = dyn_cast<FunctionDecl>(Found);
+    const FunctionDecl *Definition;
+    if (FoundFD && FoundFD->hasBody(Definition) &&
+        getLookupName(Definition) == LookupFnName)
+      return Definition;
+  }
+  return nullptr;
 }
 
 void CrossTranslationUnitContext::emitCrossTUDiagnostics(const IndexError &IE) {
@@ -201,24 +437,11 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
   ASTUnit *Unit = nullptr;
   auto FnUnitCacheEntry = FunctionASTUnitMap.find(LookupName);
   if (FnUnitCacheEntry == FunctionASTUnitMap.end()) {
-    if (FunctionFileMap.empty()) {
-      SmallString<256> IndexFile = CrossTUDir;
-      if (llvm::sys::path::is_absolute(IndexName))
-        IndexFile = IndexName;
-      else
-        llvm::sys::path::append(IndexFile, IndexName);
-      llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
-          parseCrossTUIndex(IndexFile, CrossTUDir);
-      if (IndexOrErr)
-        FunctionFileMap = *IndexOrErr;
-      else
-        return IndexOrErr.takeError();
-    }
-
-    auto It = FunctionFileMap.find(LookupName);
-    if (It == FunctionFileMap.end())
-      return llvm::make_error<IndexError>(index_error_code::missing_definition);
-    StringRef ASTFileName = It->second;
+    llvm::Expected<std::string> ASTFileNameOrErr =
+        getASTFileName(LookupName, CrossTUDir, IndexName);
+    if (!ASTFileNameOrErr)
+      return ASTFileNameOrErr.takeError();
+    StringRef ASTFileName = *ASTFileNameOrErr;
     auto ASTCacheEntry = FileASTUnitMap.find(ASTFileName);
     if (ASTCacheEntry == FileASTUnitMap.end()) {
       IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
@@ -240,9 +463,97 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
   } else {
     Unit = FnUnitCacheEntry->second;
   }
+  if (Unit)
+    ASTUnitLastUse[Unit] = ++ASTUnitUseCount;
   return Unit;
 }
 
+llvm::Expected<std::string>
+CrossTranslationUnitContext::getASTFileName(StringRef LookupName,
+                                            StringRef CrossTUDir,
+                                            StringRef IndexName) {
+  if (!FunctionFileIndex && FunctionFileMap.empty()) {
+    SmallString<256> IndexFile = CrossTUDir;
+    if (llvm::sys::path::is_absolute(IndexName))
+      IndexFile = IndexName;
+    else
+      llvm::sys::path::append(IndexFile, IndexName);
+
+    // Look up the index files in the binary format without loading them.
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+        llvm::MemoryBuffer::getFile(IndexFile, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+    if (BufferOrErr && isBinaryIndex(**BufferOrErr)) {
+      BinaryIndexTable *Table = createBinaryIndexTable(**BufferOrErr);
+      if (!Table)
+        return llvm::make_error<IndexError>(
+            index_error_code::invalid_index_format, IndexFile.str());
+      FunctionFileIndex =
+          llvm::make_unique<BinaryIndex>(std::move(*BufferOrErr), Table);
+    }
+
+    if (!FunctionFileIndex) {
+      llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
+          parseCrossTUIndex(IndexFile, CrossTUDir);
+      if (IndexOrErr)
+        FunctionFileMap = *IndexOrErr;
+      else
+        return IndexOrErr.takeError();
+    }
+  }
+
+  if (FunctionFileIndex) {
+    StringRef FileName = FunctionFileIndex->lookup(LookupName);
+    if (FileName.empty())
+      return llvm::make_error<IndexError>(index_error_code::missing_definition);
+    return getASTFilePath(CrossTUDir, FileName);
+  }
+
+  auto It = FunctionFileMap.find(LookupName);
+  if (It == FunctionFileMap.end())
+    return llvm::make_error<IndexError>(index_error_code::missing_definition);
+  return It->second;
+}
+
+void CrossTranslationUnitContext::unloadASTUnits(const ASTUnit *InUse) {
+  if (!LoadedASTMemoryLimit)
+    return;
+
+  uint64_t LoadedASTMemory = 0;
+  for (const auto &Entry : FileASTUnitMap)
+    if (Entry.second)
+      LoadedASTMemory += getASTUnitMemory(*Entry.second);
+
+  while (LoadedASTMemory > LoadedASTMemoryLimit) {
+    auto LeastRecentlyUsed = FileASTUnitMap.end();
+    for (auto I = FileASTUnitMap.begin(), E = FileASTUnitMap.end(); I != E;
+         ++I) {
+      if (!I->second || I->second.get() == InUse)
+        continue;
+      if (LeastRecentlyUsed == E ||
+          ASTUnitLastUse[I->second.get()] <
+              ASTUnitLastUse[LeastRecentlyUsed->second.get()])
+        LeastRecentlyUsed = I;
+    }
+    if (LeastRecentlyUsed == FileASTUnitMap.end())
+      break;
+
+    // The definitions imported from the ASTUnit are copies owned by the
+    // current AST, so only the lookups referring to it have to be dropped.
+    ASTUnit *Unit = LeastRecentlyUsed->second.get();
+    LoadedASTMemory -= getASTUnitMemory(*Unit);
+    ASTUnitImporterMap.erase(Unit->getASTContext().getTranslationUnitDecl());
+    for (auto I = FunctionASTUnitMap.begin(), E = FunctionASTUnitMap.end();
+         I != E;) {
+      auto Current = I++;
+      if (Current->second == Unit)
+        FunctionASTUnitMap.erase(Current);
+    }
+    ASTUnitLastUse.erase(Unit);
+    FileASTUnitMap.erase(LeastRecentlyUsed);
+  }
+}
+
 llvm::Expected<const FunctionDecl *>
 CrossTranslationUnitContext::importDefinition(const FunctionDecl *FD) {
   ASTImporter &Importer = getOrCreateASTImporter(FD->getASTContext());
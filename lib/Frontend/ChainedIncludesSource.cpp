@@ -14,6 +14,7 @@
 
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Lex/Preprocessor.h"
@@ -22,7 +23,11 @@
 #include "clang/Sema/MultiplexExternalSemaSource.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 
 using namespace clang;
 
@@ -110,6 +115,125 @@ createASTReader(CompilerInstance &CI, StringRef pchFile,
   return nullptr;
 }
 
+static SmallString<32> hashFileContents(StringRef Path) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buf =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buf)
+    return SmallString<32>();
+
+  llvm::MD5 Hash;
+  llvm::MD5::MD5Result Result;
+  SmallString<32> Res;
+  Hash.update((*Buf)->getBuffer());
+  Hash.final(Result);
+  llvm::MD5::stringifyResult(Result, Res);
+  return Res;
+}
+
+/// Compute the cache key of the chained PCH for \p Include. The key covers
+/// the contents of the PCH it is chained on top of, so a rebuilt link
+/// invalidates every link after it unless it came out identical.
+static SmallString<32> getChainedIncludeKey(CompilerInstance &CI,
+                                            StringRef PrevPCH,
+                                            StringRef Include, unsigned Index) {
+  llvm::MD5 Hash;
+  llvm::MD5::MD5Result Result;
+  SmallString<32> Res;
+  Hash.update(CI.getInvocation().getModuleHash());
+  Hash.update(PrevPCH);
+  Hash.update(Include);
+  Hash.update(llvm::utostr(Index));
+  Hash.final(Result);
+  llvm::MD5::stringifyResult(Result, Res);
+  return Res;
+}
+
+/// Try to load the cached chained PCH with the given key. The cache entry is
+/// only used if every input file recorded next to it still has the same
+/// contents.
+static std::unique_ptr<llvm::MemoryBuffer>
+loadCachedChainedPCH(StringRef CacheDir, StringRef Key) {
+  SmallString<128> PCHPath(CacheDir);
+  llvm::sys::path::append(PCHPath, Key + ".pch");
+  SmallString<128> InputsPath(CacheDir);
+  llvm::sys::path::append(InputsPath, Key + ".inputs");
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Inputs =
+      llvm::MemoryBuffer::getFile(InputsPath);
+  if (!Inputs)
+    return nullptr;
+
+  // Each line is "<md5> <path>".
+  SmallVector<StringRef, 16> Lines;
+  (*Inputs)->getBuffer().split(Lines, '\n', -1, /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    std::pair<StringRef, StringRef> Split = Line.split(' ');
+    if (Split.second.empty() || hashFileContents(Split.second) != Split.first)
+      return nullptr;
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> PCH =
+      llvm::MemoryBuffer::getFile(PCHPath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!PCH)
+    return nullptr;
+  return std::move(*PCH);
+}
+
+static bool writeCacheFile(StringRef Path, StringRef Data) {
+  // Write to a temporary file and rename it, so that concurrent compilations
+  // never observe a partially written entry.
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return true;
+
+  llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+  Out << Data;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
+
+/// Store a freshly built chained PCH in the cache, along with the contents
+/// hashes of every file that went into it.
+static void storeCachedChainedPCH(StringRef CacheDir, StringRef Key,
+                                  SourceManager &SM, StringRef PCHData) {
+  if (llvm::sys::fs::create_directories(CacheDir))
+    return;
+
+  std::string InputList;
+  llvm::raw_string_ostream OS(InputList);
+  for (auto I = SM.fileinfo_begin(), E = SM.fileinfo_end(); I != E; ++I) {
+    StringRef Name = I->first->getName();
+    SmallString<32> Hash = hashFileContents(Name);
+    if (Hash.empty())
+      return;
+    OS << Hash << ' ' << Name << '\n';
+  }
+  OS.flush();
+
+  SmallString<128> PCHPath(CacheDir);
+  llvm::sys::path::append(PCHPath, Key + ".pch");
+  SmallString<128> InputsPath(CacheDir);
+  llvm::sys::path::append(InputsPath, Key + ".inputs");
+
+  // Write the PCH before the input list; an entry without an input list is
+  // never used.
+  if (writeCacheFile(PCHPath, PCHData))
+    return;
+  writeCacheFile(InputsPath, InputList);
+}
+
 IntrusiveRefCntPtr<ExternalSemaSource> clang::createChainedIncludesSource(
     CompilerInstance &CI, IntrusiveRefCntPtr<ExternalSemaSource> &Reader) {
 
@@ -122,12 +246,41 @@ IntrusiveRefCntPtr<ExternalSemaSource> clang::createChainedIncludesSource(
   SmallVector<std::unique_ptr<llvm::MemoryBuffer>, 4> SerialBufs;
   SmallVector<std::string, 4> serialBufNames;
 
+  StringRef CacheDir = CI.getPreprocessorOpts().ChainedIncludesCachePath;
+
   for (unsigned i = 0, e = includes.size(); i != e; ++i) {
     bool firstInclude = (i == 0);
+
+    // The name under which the previous link is chained must not depend on
+    // whether it was rebuilt or loaded from the cache.
+    if (!firstInclude) {
+      std::string pchName = includes[i-1];
+      llvm::raw_string_ostream os(pchName);
+      os << ".pch" << i-1;
+      serialBufNames.push_back(os.str());
+    }
+
+    SmallString<32> Key;
+    if (!CacheDir.empty()) {
+      Key = getChainedIncludeKey(
+          CI, firstInclude ? StringRef() : SerialBufs.back()->getBuffer(),
+          includes[i], i);
+      if (std::unique_ptr<llvm::MemoryBuffer> Cached =
+              loadCachedChainedPCH(CacheDir, Key)) {
+        CI.getDiagnostics().Report(diag::remark_chain_include_cache_hit)
+            << includes[i];
+        SerialBufs.push_back(std::move(Cached));
+        continue;
+      }
+      CI.getDiagnostics().Report(diag::remark_chain_include_cache_miss)
+          << includes[i];
+    }
+
     std::unique_ptr<CompilerInvocation> CInvok;
     CInvok.reset(new CompilerInvocation(CI.getInvocation()));
     
     CInvok->getPreprocessorOpts().ChainedIncludes.clear();
+    CInvok->getPreprocessorOpts().ChainedIncludesCachePath.clear();
     CInvok->getPreprocessorOpts().ImplicitPCHInclude.clear();
     CInvok->getPreprocessorOpts().ImplicitPTHInclude.clear();
     CInvok->getPreprocessorOpts().DisablePCHValidation = true;
@@ -160,9 +313,12 @@ IntrusiveRefCntPtr<ExternalSemaSource> clang::createChainedIncludesSource(
 
     auto Buffer = std::make_shared<PCHBuffer>();
     ArrayRef<std::shared_ptr<ModuleFileExtension>> Extensions;
+    // Cached links must be byte-for-byte reproducible, so leave out
+    // timestamps when caching.
     auto consumer = llvm::make_unique<PCHGenerator>(
         Clang->getPreprocessor(), "-", /*isysroot=*/"", Buffer,
-        Extensions, /*AllowASTWithErrors=*/true);
+        Extensions, /*AllowASTWithErrors=*/true,
+        /*IncludeTimestamps=*/CacheDir.empty());
     Clang->getASTContext().setASTMutationListener(
                                             consumer->GetASTMutationListener());
     Clang->setASTConsumer(std::move(consumer));
@@ -179,14 +335,10 @@ IntrusiveRefCntPtr<ExternalSemaSource> clang::createChainedIncludesSource(
       // allocating new ones.
       for (auto &SB : SerialBufs)
         Bufs.push_back(llvm::MemoryBuffer::getMemBuffer(SB->getBuffer()));
-      std::string pchName = includes[i-1];
-      llvm::raw_string_ostream os(pchName);
-      os << ".pch" << i-1;
-      serialBufNames.push_back(os.str());
 
       IntrusiveRefCntPtr<ASTReader> Reader;
       Reader = createASTReader(
-          *Clang, pchName, Bufs, serialBufNames,
+          *Clang, serialBufNames.back(), Bufs, serialBufNames,
           Clang->getASTConsumer().GetASTDeserializationListener());
       if (!Reader)
         return nullptr;
@@ -201,6 +353,9 @@ IntrusiveRefCntPtr<ExternalSemaSource> clang::createChainedIncludesSource(
     Clang->getDiagnosticClient().EndSourceFile();
     assert(Buffer->IsComplete && "serialization did not complete");
     auto &serialAST = Buffer->Data;
+    if (!CacheDir.empty() && !Clang->getDiagnostics().hasErrorOccurred())
+      storeCachedChainedPCH(CacheDir, Key, Clang->getSourceManager(),
+                            StringRef(serialAST.data(), serialAST.size()));
     SerialBufs.push_back(llvm::MemoryBuffer::getMemBufferCopy(
         StringRef(serialAST.data(), serialAST.size())));
     serialAST.clear();
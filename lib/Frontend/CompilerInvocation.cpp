@@ -63,6 +63,7 @@
 #include "llvm/Option/OptTable.h"
 #include "llvm/Option/Option.h"
 #include "llvm/ProfileData/InstrProfReader.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
@@ -343,6 +344,22 @@ static bool ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
     }
   }
 
+  // An out-of-range shard index would silently analyze another shard again.
+  auto ShardIndex = Opts.Config.find("analysis-shard-index");
+  if (ShardIndex != Opts.Config.end()) {
+    unsigned Count = 1, Index;
+    auto ShardCount = Opts.Config.find("analysis-shard-count");
+    if (ShardCount != Opts.Config.end() &&
+        StringRef(ShardCount->getValue()).getAsInteger(10, Count))
+      Count = 1;
+    if (StringRef(ShardIndex->getValue()).getAsInteger(10, Index) ||
+        Index >= std::max(Count, 1u)) {
+      Diags.Report(SourceLocation(), diag::err_analyzer_config_shard_index)
+          << ShardIndex->getValue() << std::max(Count, 1u);
+      Success = false;
+    }
+  }
+
   llvm::raw_string_ostream os(Opts.FullCompilerInvocation);
   for (unsigned i = 0; i < Args.getNumInputArgStrings(); ++i) {
     if (i != 0)
@@ -597,6 +614,81 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.LTOVisibilityPublicStd = Args.hasArg(OPT_flto_visibility_public_std);
   Opts.EnableSplitDwarf = Args.hasArg(OPT_enable_split_dwarf);
   Opts.SplitDwarfFile = Args.getLastArgValue(OPT_split_dwarf_file);
+  Opts.ParallelCodeGen =
+      getLastArgIntValue(Args, OPT_fparallel_codegen_EQ, 1, Diags);
+  Opts.ParallelCodeGenOutputs =
+      Args.getAllArgValues(OPT_parallel_codegen_output);
+  if (Opts.ParallelCodeGen == 0)
+    Opts.ParallelCodeGen = 1;
+  // Every partition is written to its own output file; there is no single
+  // output to link them into.
+  unsigned NumPartitionOutputs =
+      Opts.ParallelCodeGen > 1 ? Opts.ParallelCodeGen : 0;
+  if (Opts.ParallelCodeGenOutputs.size() != NumPartitionOutputs)
+    Diags.Report(diag::err_drv_parallel_codegen_outputs)
+        << Opts.ParallelCodeGen << NumPartitionOutputs
+        << (unsigned)Opts.ParallelCodeGenOutputs.size();
+  if (Opts.ParallelCodeGen > 1) {
+    std::string ParallelArg =
+        Args.getLastArg(OPT_fparallel_codegen_EQ)->getAsString(Args);
+    if (Args.hasArg(OPT_o)) {
+      Diags.Report(diag::err_drv_argument_not_allowed_with)
+          << ParallelArg << "-o";
+      Success = false;
+    }
+    // Partitions are only written by the legacy pass manager's code
+    // generation for object files and assembly; any other output would be
+    // silently dropped.
+    if (FrontendOpts.ProgramAction != frontend::EmitObj &&
+        FrontendOpts.ProgramAction != frontend::EmitAssembly) {
+      Diags.Report(diag::err_drv_parallel_codegen_action)
+          << Opts.ParallelCodeGen;
+      Success = false;
+    }
+    if (Opts.ExperimentalNewPassManager) {
+      Diags.Report(diag::err_drv_argument_not_allowed_with)
+          << ParallelArg << "-fexperimental-new-pass-manager";
+      Success = false;
+    }
+    if (Arg *A = Args.getLastArg(OPT_fthinlto_index_EQ)) {
+      Diags.Report(diag::err_drv_argument_not_allowed_with)
+          << ParallelArg << A->getAsString(Args);
+      Success = false;
+    }
+  }
+  // The cache holds the code of partitions; without partitions it would
+  // never be used.
+  if (Arg *A = Args.getLastArg(OPT_fparallel_codegen_cache_path_EQ)) {
+    if (Opts.ParallelCodeGen > 1) {
+      Opts.ParallelCodeGenCachePath = A->getValue();
+    } else {
+      Diags.Report(diag::err_drv_argument_only_allowed_with)
+          << A->getAsString(Args) << "-fparallel-codegen=<N>";
+      Success = false;
+    }
+  }
+  if (Arg *A = Args.getLastArg(OPT_fparallel_codegen_cache_policy_EQ)) {
+    StringRef Policy = A->getValue();
+    if (auto E = llvm::parseCachePruningPolicy(Policy).takeError()) {
+      llvm::consumeError(std::move(E));
+      Diags.Report(diag::err_drv_invalid_value)
+          << A->getAsString(Args) << Policy;
+      Success = false;
+    } else {
+      Opts.ParallelCodeGenCachePruningPolicy = Policy;
+    }
+    if (!Args.hasArg(OPT_fparallel_codegen_cache_path_EQ)) {
+      Diags.Report(diag::err_drv_argument_only_allowed_with)
+          << A->getAsString(Args) << "-fparallel-codegen-cache-path=<dir>";
+      Success = false;
+    }
+  }
+  Opts.LLVMArgs = Args.getAllArgValues(OPT_mllvm);
+  // The split DWARF output cannot be divided between the partitions.
+  if (Opts.ParallelCodeGen > 1 && !Opts.SplitDwarfFile.empty())
+    Diags.Report(diag::err_drv_argument_not_allowed_with)
+        << Args.getLastArg(OPT_fparallel_codegen_EQ)->getAsString(Args)
+        << "-split-dwarf-file";
   Opts.SplitDwarfInlining = !Args.hasArg(OPT_fno_split_dwarf_inlining);
   Opts.DebugTypeExtRefs = Args.hasArg(OPT_dwarf_ext_refs);
   Opts.DebugExplicitImport = Args.hasArg(OPT_dwarf_explicit_import);
@@ -605,12 +697,14 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   for (const auto &Arg : Args.getAllArgValues(OPT_fdebug_prefix_map_EQ))
     Opts.DebugPrefixMap.insert(StringRef(Arg).split('='));
+  Opts.DebugTypeManifest = Args.getLastArgValue(OPT_fdebug_type_manifest_EQ);
 
   if (const Arg *A =
           Args.getLastArg(OPT_emit_llvm_uselists, OPT_no_emit_llvm_uselists))
     Opts.EmitLLVMUseLists = A->getOption().getID() == OPT_emit_llvm_uselists;
 
   Opts.DisableLLVMPasses = Args.hasArg(OPT_disable_llvm_passes);
+  Opts.PruneDeferredDecls = Args.hasArg(OPT_fprune_deferred_decls);
   Opts.DisableLifetimeMarkers = Args.hasArg(OPT_disable_lifetimemarkers);
   Opts.DisableO0ImplyOptNone = Args.hasArg(OPT_disable_O0_optnone);
   Opts.DisableRedZone = Args.hasArg(OPT_disable_red_zone);
@@ -621,6 +715,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.StructPathTBAA = !Args.hasArg(OPT_no_struct_path_tbaa);
   Opts.NewStructPathTBAA = !Args.hasArg(OPT_no_struct_path_tbaa) &&
                            Args.hasArg(OPT_new_struct_path_tbaa);
+  Opts.HashTBAATypeNames = Args.hasArg(OPT_hash_tbaa_type_names);
   Opts.FineGrainedBitfieldAccesses =
       Args.hasFlag(OPT_ffine_grained_bitfield_accesses,
                    OPT_fno_fine_grained_bitfield_accesses, false);
@@ -650,8 +745,24 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
       Args.getLastArgValue(OPT_fprofile_instrument_path_EQ);
   Opts.ProfileInstrumentUsePath =
       Args.getLastArgValue(OPT_fprofile_instrument_use_path_EQ);
+  Opts.ProfileInstrumentUseSubsetPath =
+      Args.getLastArgValue(OPT_fprofile_instrument_use_subset_path_EQ);
+  Opts.ProfileInstrumentSubsetOutput =
+      Args.getLastArgValue(OPT_fprofile_instrument_subset_output_EQ);
+  // Subsets are only written for frontend instrumentation profiles. Checking
+  // the subset, when there is one, saves opening the full profile.
   if (!Opts.ProfileInstrumentUsePath.empty())
-    setPGOUseInstrumentor(Opts, Opts.ProfileInstrumentUsePath);
+    setPGOUseInstrumentor(Opts, Opts.ProfileInstrumentUseSubsetPath.empty()
+                                    ? Opts.ProfileInstrumentUsePath
+                                    : Opts.ProfileInstrumentUseSubsetPath);
+  else
+    for (OptSpecifier Opt : {OPT_fprofile_instrument_use_subset_path_EQ,
+                             OPT_fprofile_instrument_subset_output_EQ})
+      if (Arg *A = Args.getLastArg(Opt)) {
+        Diags.Report(diag::err_drv_argument_only_allowed_with)
+            << A->getAsString(Args) << "-fprofile-instrument-use-path=";
+        Success = false;
+      }
 
   Opts.CoverageMapping =
       Args.hasFlag(OPT_fcoverage_mapping, OPT_fno_coverage_mapping, false);
@@ -1742,6 +1853,8 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
     Opts.AddPrebuiltModulePath(A->getValue());
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
   Opts.ModulesHashContent = Args.hasArg(OPT_fmodules_hash_content);
+  Opts.ModulesPruneUnreachableLookups =
+      Args.hasArg(OPT_fmodules_prune_unreachable_lookups);
   Opts.ModulesValidateDiagnosticOptions =
       !Args.hasArg(OPT_fmodules_disable_diagnostic_validation);
   Opts.ImplicitModuleMaps = Args.hasArg(OPT_fimplicit_module_maps);
@@ -2379,6 +2492,7 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       Args.hasArg(OPT_fmodules_local_submodule_visibility) || Opts.ModulesTS;
   Opts.ModulesCodegen = Args.hasArg(OPT_fmodules_codegen);
   Opts.ModulesDebugInfo = Args.hasArg(OPT_fmodules_debuginfo);
+  Opts.ModulesRecordLayouts = Args.hasArg(OPT_fmodules_record_layouts);
   Opts.ModulesSearchAll = Opts.Modules &&
     !Args.hasArg(OPT_fno_modules_search_all) &&
     Args.hasArg(OPT_fmodules_search_all);
@@ -2878,6 +2992,9 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
 
   for (const auto *A : Args.filtered(OPT_chain_include))
     Opts.ChainedIncludes.emplace_back(A->getValue());
+  Opts.ChainedIncludesCachePath =
+      Args.getLastArgValue(OPT_chain_include_cache_path);
+  Opts.PCHPrefetchProfile = Args.getLastArgValue(OPT_pch_prefetch_profile);
 
   for (const auto *A : Args.filtered(OPT_remap_file)) {
     std::pair<StringRef, StringRef> Split = StringRef(A->getValue()).split(';');
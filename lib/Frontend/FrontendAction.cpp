@@ -929,6 +929,11 @@ void FrontendAction::EndSourceFile() {
   // Inform the diagnostic client we are done with this source file.
   CI.getDiagnosticClient().EndSourceFile();
 
+  // Record which declarations of the PCH this translation unit needed.
+  if (!CI.getPreprocessorOpts().PCHPrefetchProfile.empty())
+    if (IntrusiveRefCntPtr<ASTReader> Reader = CI.getModuleManager())
+      Reader->writePrefetchProfile();
+
   // Inform the preprocessor we are done.
   if (CI.hasPreprocessor())
     CI.getPreprocessor().EndSourceFile();
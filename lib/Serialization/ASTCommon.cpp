@@ -15,8 +15,12 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/TargetInfo.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/Support/DJB.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MD5.h"
 
 using namespace clang;
 
@@ -250,6 +254,38 @@ unsigned serialization::ComputeHash(Selector Sel) {
   return R;
 }
 
+uint64_t serialization::getRecordLayoutHash(const ASTContext &Context) {
+  // Most of these are already checked when the AST file is loaded; hashing
+  // them again keeps stale layouts from being used if that ever changes.
+  // The hash is stored in AST files, so it must be the same in every process
+  // and on every host, unlike llvm::hash_code.
+  llvm::MD5 Hash;
+  auto AddInt = [&Hash](uint64_t V) {
+    uint8_t Bytes[8];
+    llvm::support::endian::write64le(Bytes, V);
+    Hash.update(llvm::makeArrayRef(Bytes));
+  };
+  auto AddString = [&](StringRef S) {
+    AddInt(S.size());
+    Hash.update(S);
+  };
+
+  const TargetInfo &Target = Context.getTargetInfo();
+  const LangOptions &LangOpts = Context.getLangOpts();
+  AddString(Target.getTriple().str());
+  AddString(Target.getDataLayout().getStringRepresentation());
+  AddInt(unsigned(Target.getCXXABI().getKind()));
+  AddInt(LangOpts.MSBitfields);
+  AddInt(LangOpts.PackStruct);
+  AddInt(LangOpts.MaxTypeAlign);
+  AddInt(LangOpts.AlignDouble);
+  AddInt(unsigned(LangOpts.getClangABICompat()));
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.low();
+}
+
 const DeclContext *
 serialization::getDefinitiveDeclContext(const DeclContext *DC) {
   switch (DC->getDeclKind()) {
@@ -72,6 +72,10 @@ TypeID MakeTypeID(ASTContext &Context, QualType T, IdxForTypeTy IdxForType) {
 
 unsigned ComputeHash(Selector Sel);
 
+/// Compute a hash of the target and language options that determine the
+/// layout of records, used to validate layouts stored in AST files.
+uint64_t getRecordLayoutHash(const ASTContext &Context);
+
 /// Retrieve the "definitive" declaration that provides all of the
 /// visible entries for the given declaration context, if there is one.
 ///
@@ -32,6 +32,7 @@
 #include "clang/AST/NestedNameSpecifier.h"
 #include "clang/AST/ODRHash.h"
 #include "clang/AST/RawCommentList.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/TemplateBase.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
@@ -1865,21 +1866,39 @@ namespace {
     unsigned PriorGeneration;
     unsigned &NumIdentifierLookups;
     unsigned &NumIdentifierLookupHits;
+    bool PruneUnreachable;
+    bool IncludeUnreachable;
+    unsigned PriorUnreachableGeneration;
     IdentifierInfo *Found = nullptr;
 
   public:
     IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration,
                             unsigned &NumIdentifierLookups,
-                            unsigned &NumIdentifierLookupHits)
+                            unsigned &NumIdentifierLookupHits,
+                            bool PruneUnreachable = false,
+                            bool IncludeUnreachable = false,
+                            unsigned PriorUnreachableGeneration = 0)
       : Name(Name), NameHash(ASTIdentifierLookupTrait::ComputeHash(Name)),
         PriorGeneration(PriorGeneration),
         NumIdentifierLookups(NumIdentifierLookups),
-        NumIdentifierLookupHits(NumIdentifierLookupHits) {}
+        NumIdentifierLookupHits(NumIdentifierLookupHits),
+        PruneUnreachable(PruneUnreachable),
+        IncludeUnreachable(IncludeUnreachable),
+        PriorUnreachableGeneration(PriorUnreachableGeneration) {}
 
     bool operator()(ModuleFile &M) {
-      // If we've already searched this module file, skip it now.
-      if (M.Generation <= PriorGeneration)
-        return true;
+      if (M.LookupPruned) {
+        // Unreachable module files are only searched when completing
+        // redeclaration chains, and only if they were loaded after the chains
+        // were last completed.
+        if (!IncludeUnreachable || M.Generation <= PriorUnreachableGeneration)
+          return false;
+      } else if (M.LookupGeneration <= PriorGeneration) {
+        // If we've already searched this module file, skip it now. When
+        // pruning, don't skip its imports; they may have become reachable
+        // after it was searched.
+        return !PruneUnreachable;
+      }
 
       ASTIdentifierLookupTable *IdTable
         = (ASTIdentifierLookupTable *)M.IdentifierLookupTable;
@@ -1910,12 +1929,24 @@ namespace {
 } // namespace
 
 void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
+  lookupOutOfDateIdentifier(II, /*IncludeUnreachable=*/false);
+}
+
+/// Look up an out-of-date identifier in the module files that have not been
+/// searched for it yet. If \p IncludeUnreachable is true, module files that
+/// are pruned from lookups and have not been searched for it are searched
+/// too.
+void ASTReader::lookupOutOfDateIdentifier(IdentifierInfo &II,
+                                          bool IncludeUnreachable) {
   // Note that we are loading an identifier.
   Deserializing AnIdentifier(this);
 
   unsigned PriorGeneration = 0;
   if (getContext().getLangOpts().Modules)
     PriorGeneration = IdentifierGeneration[&II];
+  unsigned PriorUnreachableGeneration = 0;
+  if (IncludeUnreachable)
+    PriorUnreachableGeneration = CompletedRedeclChainGeneration.lookup(&II);
 
   // If there is a global index, look there first to determine which modules
   // provably do not have any results for this identifier.
@@ -1929,9 +1960,13 @@ void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
 
   IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration,
                                   NumIdentifierLookups,
-                                  NumIdentifierLookupHits);
+                                  NumIdentifierLookupHits,
+                                  PruneUnreachableLookups, IncludeUnreachable,
+                                  PriorUnreachableGeneration);
   ModuleMgr.visit(Visitor, HitsPtr);
   markIdentifierUpToDate(&II);
+  if (IncludeUnreachable)
+    CompletedRedeclChainGeneration[&II] = getGeneration();
 }
 
 void ASTReader::markIdentifierUpToDate(IdentifierInfo *II) {
@@ -3266,6 +3301,18 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       F.ObjCCategories.swap(Record);
       break;
 
+    case RECORD_LAYOUTS:
+      // Each layout is preceded by the ID of its record and its length. The
+      // layouts themselves are only read once the ASTContext asks for them.
+      F.RecordLayouts.swap(Record);
+      for (unsigned Idx = 1, N = F.RecordLayouts.size(); Idx + 1 < N;) {
+        serialization::GlobalDeclID ID =
+            getGlobalDeclID(F, F.RecordLayouts[Idx]);
+        PrecomputedRecordLayouts[ID] = {&F, Idx + 2};
+        Idx += 2 + F.RecordLayouts[Idx + 1];
+      }
+      break;
+
     case CUDA_SPECIAL_DECL_REFS:
       // Later tables overwrite earlier ones.
       // FIXME: Modules will have trouble with this.
@@ -3715,6 +3762,7 @@ void ASTReader::makeModuleVisible(Module *Mod,
                                   Module::NameVisibilityKind NameVisibility,
                                   SourceLocation ImportLoc) {
   llvm::SmallPtrSet<Module *, 4> Visited;
+  SmallVector<ModuleFile *, 4> NewlyReachable;
   SmallVector<Module *, 4> Stack;
   Stack.push_back(Mod);
   while (!Stack.empty()) {
@@ -3734,6 +3782,14 @@ void ASTReader::makeModuleVisible(Module *Mod,
     // Update the module's name visibility.
     Mod->NameVisibility = NameVisibility;
 
+    // Start searching the module file this module lives in.
+    if (PruneUnreachableLookups && Mod->getASTFile())
+      if (ModuleFile *MF = ModuleMgr.lookup(Mod->getASTFile()))
+        if (MF->LookupPruned) {
+          MF->LookupPruned = false;
+          NewlyReachable.push_back(MF);
+        }
+
     // If we've already deserialized any names from this module,
     // mark them as visible.
     HiddenNamesMapType::iterator Hidden = HiddenNamesMap.find(Mod);
@@ -3755,6 +3811,27 @@ void ASTReader::makeModuleVisible(Module *Mod,
         Stack.push_back(Exported);
     }
   }
+
+  if (!NewlyReachable.empty())
+    searchNewlyReachableModuleFiles(NewlyReachable);
+}
+
+void ASTReader::searchNewlyReachableModuleFiles(
+    ArrayRef<ModuleFile *> ModuleFiles) {
+  // Treat the module files as if they had just been loaded: give them a new
+  // generation and force identifiers and selectors to be looked up again,
+  // which will only search module files of the new generation.
+  if (ContextObj)
+    incrementGeneration(*ContextObj);
+  for (ModuleFile *MF : ModuleFiles)
+    MF->LookupGeneration = getGeneration();
+
+  for (IdentifierTable::iterator Id = PP.getIdentifierTable().begin(),
+                                 IdEnd = PP.getIdentifierTable().end();
+       Id != IdEnd; ++Id)
+    Id->second->setOutOfDate(true);
+  for (auto Sel : SelectorGeneration)
+    SelectorOutOfDate[Sel.first] = true;
 }
 
 /// We've merged the definition \p MergedDef into the existing definition
@@ -4037,6 +4114,11 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
   // Might be unnecessary as use declarations are only used to build the
   // module itself.
 
+  // Start faulting in the declarations the last translation unit needed
+  // first, while we carry on initializing and preprocessing.
+  if (Type == MK_PCH && !PrefetchProfilePath.empty() && !PrefetchModule)
+    startPrefetching(ModuleMgr.getPrimaryModule());
+
   if (ContextObj)
     InitializeContext();
 
@@ -4086,6 +4168,91 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
   return Success;
 }
 
+/// Identifies the PCH a prefetch profile was recorded against.
+static std::string getPrefetchProfileKey(const ModuleFile &F) {
+  return F.FileName + " " + llvm::utostr(F.File->getSize()) + " " +
+         llvm::utostr(F.File->getModificationTime());
+}
+
+void ASTReader::startPrefetching(ModuleFile &F) {
+  if (!F.File)
+    return;
+
+  // Record the declarations of this PCH as they are read.
+  PrefetchModule = &F;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Profile =
+      llvm::MemoryBuffer::getFile(PrefetchProfilePath);
+  if (!Profile)
+    return;
+
+  // Ignore profiles recorded against a different PCH.
+  SmallVector<StringRef, 64> Lines;
+  (*Profile)->getBuffer().split(Lines, '\n', -1, /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines[0] != getPrefetchProfileKey(F))
+    return;
+
+  StringRef Bytes = PCHContainerRdr.ExtractPCH(*F.Buffer);
+  std::vector<const char *> Addrs;
+  for (StringRef Line : llvm::makeArrayRef(Lines).drop_front()) {
+    uint64_t BitOffset;
+    if (Line.getAsInteger(10, BitOffset) || BitOffset / 8 >= Bytes.size())
+      continue;
+    Addrs.push_back(Bytes.data() + BitOffset / 8);
+  }
+  if (Addrs.empty())
+    return;
+  NumPrefetchedDecls = Addrs.size();
+
+  // Touch each record in the order the last translation unit needed it.
+  // The buffer is only read, so this cannot race with deserialization.
+  PrefetchThread = llvm::make_unique<llvm::thread>([Addrs] {
+    volatile char Sink;
+    for (const char *Addr : Addrs)
+      Sink = *Addr;
+    (void)Sink;
+  });
+}
+
+void ASTReader::writePrefetchProfile() {
+  if (PrefetchThread) {
+    PrefetchThread->join();
+    PrefetchThread.reset();
+  }
+
+  if (!PrefetchModule || PrefetchProfileOffsets.empty())
+    return;
+
+  // Write the profile to a temporary file and rename it into place, so that
+  // concurrent compilations never read a partially written profile.
+  std::string Key = getPrefetchProfileKey(*PrefetchModule);
+  PrefetchModule = nullptr;
+  std::vector<uint64_t> Offsets = std::move(PrefetchProfileOffsets);
+  PrefetchProfileOffsets.clear();
+
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(PrefetchProfilePath + "-%%%%%%%%", FD,
+                                      TempPath))
+    return;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Key << '\n';
+    for (uint64_t Offset : Offsets)
+      OS << Offset << '\n';
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  if (llvm::sys::fs::rename(TempPath, PrefetchProfilePath))
+    llvm::sys::fs::remove(TempPath);
+}
+
 static ASTFileSignature readASTFileSignature(StringRef PCH);
 
 /// Whether \p Stream starts with the AST/PCH file magic number 'CPCH'.
@@ -4165,6 +4332,11 @@ ASTReader::ReadASTCore(StringRef FileName,
   assert(M && "Missing module file");
 
   ModuleFile &F = *M;
+  // A module file is searched by lookups once one of its modules is made
+  // visible.
+  if (PruneUnreachableLookups && F.isModule())
+    F.LookupPruned = true;
+
   BitstreamCursor &Stream = F.Stream;
   Stream = BitstreamCursor(PCHContainerRdr.ExtractPCH(*F.Buffer));
   F.SizeInBits = F.Buffer->getBufferSize() * 8;
@@ -7104,9 +7276,16 @@ void ASTReader::CompleteRedeclChain(const Decl *D) {
         // Outside of C++, we don't have a lookup table for the TU, so update
         // the identifier instead. (For C++ modules, we don't store decls
         // in the serialized identifier table, so we do the lookup in the TU.)
+        // Redeclarations must be merged even if they live in module files
+        // that are pruned from name lookups; those are searched again only
+        // once new module files have been loaded.
         auto *II = Name.getAsIdentifierInfo();
         assert(II && "non-identifier name in C?");
-        if (II->isOutOfDate())
+        if (PruneUnreachableLookups) {
+          if (II->isOutOfDate() ||
+              CompletedRedeclChainGeneration.lookup(II) != getGeneration())
+            lookupOutOfDateIdentifier(*II, /*IncludeUnreachable=*/true);
+        } else if (II->isOutOfDate())
           updateOutOfDateIdentifier(*II);
       } else
         DC->lookup(Name);
@@ -7666,6 +7845,18 @@ void ASTReader::PrintStats() {
                  "  %u / %u identifier table lookups succeeded (%f%%)\n",
                  NumIdentifierLookupHits, NumIdentifierLookups,
                  (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
+  if (NumPrefetchedDecls)
+    std::fprintf(stderr, "  %u declarations prefetched from the profile\n",
+                 NumPrefetchedDecls);
+  if (NumODRHashMergeChecksSkipped)
+    std::fprintf(stderr, "  %u merged members checked by ODR hash\n",
+                 NumODRHashMergeChecksSkipped);
+  if (!PrecomputedRecordLayouts.empty())
+    std::fprintf(stderr, "  %u/%u record layouts read (%f%%)\n",
+                 NumRecordLayoutsRead,
+                 (unsigned)PrecomputedRecordLayouts.size(),
+                 ((float)NumRecordLayoutsRead/PrecomputedRecordLayouts.size()
+                  * 100));
 
   if (GlobalIndex) {
     std::fprintf(stderr, "\n");
@@ -7979,9 +8170,16 @@ namespace serialization {
       if (!M.SelectorLookupTable)
         return false;
 
-      // If we've already searched this module file, skip it now.
-      if (M.Generation <= PriorGeneration)
-        return true;
+      // Unreachable module files are not searched until one of their modules
+      // is made visible.
+      if (M.LookupPruned)
+        return false;
+
+      // If we've already searched this module file, skip it now. When
+      // pruning, don't skip its imports; they may have become reachable after
+      // it was searched.
+      if (M.LookupGeneration <= PriorGeneration)
+        return !Reader.PruneUnreachableLookups;
 
       ++Reader.NumMethodPoolTableLookups;
       ASTSelectorLookupTable *PoolTable
@@ -8222,6 +8420,81 @@ void ASTReader::ReadUsedVTables(SmallVectorImpl<ExternalVTableUse> &VTables) {
   VTableUses.clear();
 }
 
+const ASTRecordLayout *
+ASTReader::getPrecomputedRecordLayout(const RecordDecl *Record) {
+  if (!Record->isFromASTFile())
+    return nullptr;
+  auto It = PrecomputedRecordLayouts.find(Record->getGlobalID());
+  if (It == PrecomputedRecordLayouts.end())
+    return nullptr;
+
+  ASTContext &Context = getContext();
+  ModuleFile &F = *It->second.first;
+  if (!RecordLayoutHash)
+    RecordLayoutHash = getRecordLayoutHash(Context);
+  if (F.RecordLayouts[0] != *RecordLayoutHash)
+    return nullptr;
+
+  ++NumRecordLayoutsRead;
+  const SmallVectorImpl<uint64_t> &Data = F.RecordLayouts;
+  unsigned Idx = It->second.second;
+  auto ReadCharUnits = [&] {
+    return CharUnits::fromQuantity(static_cast<int64_t>(Data[Idx++]));
+  };
+  auto ReadRecordDecl = [&]() -> const CXXRecordDecl * {
+    serialization::DeclID LocalID = Data[Idx++];
+    if (!LocalID)
+      return nullptr;
+    auto *RD = cast<CXXRecordDecl>(GetDecl(getGlobalDeclID(F, LocalID)));
+    return RD->getDefinition();
+  };
+
+  CharUnits Size = ReadCharUnits();
+  CharUnits DataSize = ReadCharUnits();
+  CharUnits Alignment = ReadCharUnits();
+  CharUnits RequiredAlignment = ReadCharUnits();
+  unsigned NumFields = Data[Idx++];
+  ArrayRef<uint64_t> FieldOffsets(Data.data() + Idx, NumFields);
+  Idx += NumFields;
+
+  if (!Data[Idx++])
+    return new (Context) ASTRecordLayout(Context, Size, Alignment,
+                                         RequiredAlignment, DataSize,
+                                         FieldOffsets);
+
+  CharUnits NonVirtualSize = ReadCharUnits();
+  CharUnits NonVirtualAlignment = ReadCharUnits();
+  CharUnits SizeOfLargestEmptySubobject = ReadCharUnits();
+  CharUnits VBPtrOffset = ReadCharUnits();
+  bool HasOwnVFPtr = Data[Idx++];
+  bool HasExtendableVFPtr = Data[Idx++];
+  bool EndsWithZeroSizedObject = Data[Idx++];
+  bool LeadsWithZeroSizedBase = Data[Idx++];
+  const CXXRecordDecl *PrimaryBase = ReadRecordDecl();
+  bool PrimaryBaseIsVirtual = Data[Idx++];
+  const CXXRecordDecl *BaseSharingVBPtr = ReadRecordDecl();
+
+  ASTRecordLayout::BaseOffsetsMapTy BaseOffsets;
+  for (unsigned I = 0, N = Data[Idx++]; I != N; ++I) {
+    const CXXRecordDecl *Base = ReadRecordDecl();
+    BaseOffsets[Base] = ReadCharUnits();
+  }
+  ASTRecordLayout::VBaseOffsetsMapTy VBaseOffsets;
+  for (unsigned I = 0, N = Data[Idx++]; I != N; ++I) {
+    const CXXRecordDecl *VBase = ReadRecordDecl();
+    CharUnits VBaseOffset = ReadCharUnits();
+    bool HasVtorDisp = Data[Idx++];
+    VBaseOffsets[VBase] = ASTRecordLayout::VBaseInfo(VBaseOffset, HasVtorDisp);
+  }
+
+  return new (Context) ASTRecordLayout(
+      Context, Size, Alignment, RequiredAlignment, HasOwnVFPtr,
+      HasExtendableVFPtr, VBPtrOffset, DataSize, FieldOffsets, NonVirtualSize,
+      NonVirtualAlignment, SizeOfLargestEmptySubobject, PrimaryBase,
+      PrimaryBaseIsVirtual, BaseSharingVBPtr, EndsWithZeroSizedObject,
+      LeadsWithZeroSizedBase, BaseOffsets, VBaseOffsets);
+}
+
 void ASTReader::ReadPendingInstantiations(
        SmallVectorImpl<std::pair<ValueDecl *, SourceLocation>> &Pending) {
   for (unsigned Idx = 0, N = PendingInstantiations.size(); Idx < N;) {
@@ -11284,7 +11557,12 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext *Context,
       AllowASTWithCompilerErrors(AllowASTWithCompilerErrors),
       AllowConfigurationMismatch(AllowConfigurationMismatch),
       ValidateSystemInputs(ValidateSystemInputs),
-      UseGlobalIndex(UseGlobalIndex), CurrSwitchCaseStmts(&SwitchCaseStmts) {
+      UseGlobalIndex(UseGlobalIndex),
+      PruneUnreachableLookups(PP.getHeaderSearchInfo()
+                                  .getHeaderSearchOpts()
+                                  .ModulesPruneUnreachableLookups),
+      PrefetchProfilePath(PP.getPreprocessorOpts().PCHPrefetchProfile),
+      CurrSwitchCaseStmts(&SwitchCaseStmts) {
   SourceMgr.setExternalSLocEntrySource(this);
 
   for (const auto &Ext : Extensions) {
@@ -11301,6 +11579,8 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext *Context,
 }
 
 ASTReader::~ASTReader() {
+  if (PrefetchThread)
+    PrefetchThread->join();
   if (OwnsDeserializationListener)
     delete DeserializationListener;
 }
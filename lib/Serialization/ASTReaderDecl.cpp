@@ -30,6 +30,7 @@
 #include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/LambdaCapture.h"
 #include "clang/AST/NestedNameSpecifier.h"
+#include "clang/AST/ODRHash.h"
 #include "clang/AST/Redeclarable.h"
 #include "clang/AST/Stmt.h"
 #include "clang/AST/TemplateBase.h"
@@ -1705,6 +1706,15 @@ void ASTDeclReader::ReadCXXDefinitionData(
   }
 }
 
+/// Whether the ODR hash of the definition of \p RD covers its members.
+/// Classes within template specializations are not hashed.
+static bool isODRHashOfMembers(const CXXRecordDecl *RD) {
+  for (const DeclContext *DC = RD; DC; DC = DC->getParent())
+    if (isa<ClassTemplateSpecializationDecl>(DC))
+      return false;
+  return true;
+}
+
 void ASTDeclReader::MergeDefinitionData(
     CXXRecordDecl *D, struct CXXRecordDecl::DefinitionData &&MergeDD) {
   assert(D->DefinitionData &&
@@ -1823,6 +1833,9 @@ void ASTDeclReader::MergeDefinitionData(
   if (DetectedOdrViolation)
     Reader.PendingOdrMergeFailures[DD.Definition].push_back(
         {MergeDD.Definition, &MergeDD});
+  else if (DD.Definition != MergeDD.Definition && !DD.IsLambda &&
+           isODRHashOfMembers(DD.Definition))
+    Reader.ODRHashMatchedDefinitions.insert(MergeDD.Definition);
 }
 
 void ASTDeclReader::ReadCXXRecordDefinition(CXXRecordDecl *D, bool Update) {
@@ -3236,8 +3249,19 @@ ASTDeclReader::FindExistingResult ASTDeclReader::findExisting(NamedDecl *D) {
   // same template specialization into the same CXXRecordDecl.
   auto MergedDCIt = Reader.MergedDeclContexts.find(D->getLexicalDeclContext());
   if (MergedDCIt != Reader.MergedDeclContexts.end() &&
-      MergedDCIt->second == D->getDeclContext())
-    Reader.PendingOdrMergeChecks.push_back(D);
+      MergedDCIt->second == D->getDeclContext()) {
+    // If the two class definitions have the same ODR hash and the hash
+    // covers this kind of member, the canonical definition has it too; we
+    // just haven't loaded it yet. Don't load every member of the canonical
+    // definition to find it.
+    auto *CanonRD = dyn_cast<CXXRecordDecl>(D->getDeclContext());
+    if (CanonRD &&
+        Reader.ODRHashMatchedDefinitions.count(D->getLexicalDeclContext()) &&
+        ODRHash::isWhitelistedDecl(D, CanonRD))
+      ++Reader.NumODRHashMergeChecksSkipped;
+    else
+      Reader.PendingOdrMergeChecks.push_back(D);
+  }
 
   return FindExistingResult(Reader, D, /*Existing=*/nullptr,
                             AnonymousDeclNumber, TypedefNameForLinkage);
@@ -3469,6 +3493,9 @@ Decl *ASTReader::ReadDeclRecord(DeclID ID) {
   SourceLocation DeclLoc;
   RecordLocation Loc = DeclCursorForID(ID, DeclLoc);
   llvm::BitstreamCursor &DeclsCursor = Loc.F->DeclsCursor;
+  if (Loc.F == PrefetchModule &&
+      PrefetchProfileOffsets.size() < MaxPrefetchProfileSize)
+    PrefetchProfileOffsets.push_back(Loc.Offset);
   // Keep track of where we are in the stream, then jump back there
   // after reading this declaration.
   SavedStreamPosition SavedPosition(DeclsCursor);
@@ -31,6 +31,7 @@
 #include "clang/AST/LambdaCapture.h"
 #include "clang/AST/NestedNameSpecifier.h"
 #include "clang/AST/RawCommentList.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
@@ -1108,6 +1109,7 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(PPD_ENTITIES_OFFSETS);
   RECORD(VTABLE_USES);
   RECORD(PPD_SKIPPED_RANGES);
+  RECORD(RECORD_LAYOUTS);
   RECORD(REFERENCED_SELECTOR_POOL);
   RECORD(TU_UPDATE_LEXICAL);
   RECORD(SEMA_DECL_REFS);
@@ -4301,6 +4303,92 @@ void ASTWriter::WriteCUDAPragmas(Sema &SemaRef) {
   }
 }
 
+/// Write the layouts of the record definitions in this AST file, so that
+/// importers can use them instead of running the record layout builder.
+void ASTWriter::WriteRecordLayouts(ASTContext &Context) {
+  if (RecordsToLayOut.empty() || ASTHasCompilerErrors)
+    return;
+
+  // Decls referenced from a layout are either imported or have been written
+  // along with the record; if neither holds, we skip the layout.
+  auto getLayoutDeclID = [&](const Decl *D) -> serialization::DeclID {
+    if (!D)
+      return 0;
+    if (D->isFromASTFile())
+      return D->getGlobalID();
+    return DeclIDs.lookup(D);
+  };
+
+  RecordData Record;
+  Record.push_back(getRecordLayoutHash(Context));
+  for (const RecordDecl *RD : RecordsToLayOut) {
+    const ASTRecordLayout &Layout = Context.getASTRecordLayout(RD);
+
+    RecordData Entry;
+    Entry.push_back(Layout.getSize().getQuantity());
+    Entry.push_back(Layout.getDataSize().getQuantity());
+    Entry.push_back(Layout.getAlignment().getQuantity());
+    Entry.push_back(Layout.getRequiredAlignment().getQuantity());
+    Entry.push_back(Layout.FieldOffsets.size());
+    Entry.append(Layout.FieldOffsets.begin(), Layout.FieldOffsets.end());
+
+    const ASTRecordLayout::CXXRecordLayoutInfo *CXXInfo = Layout.CXXInfo;
+    Entry.push_back(CXXInfo != nullptr);
+    if (CXXInfo) {
+      const CXXRecordDecl *PrimaryBase = CXXInfo->PrimaryBase.getPointer();
+      serialization::DeclID PrimaryBaseID = getLayoutDeclID(PrimaryBase);
+      serialization::DeclID BaseSharingVBPtrID =
+          getLayoutDeclID(CXXInfo->BaseSharingVBPtr);
+      if ((PrimaryBase && !PrimaryBaseID) ||
+          (CXXInfo->BaseSharingVBPtr && !BaseSharingVBPtrID))
+        continue;
+
+      // Sort the base offsets by ID, so that the output is deterministic.
+      // Unknown bases get ID 0 and thus end up at the front.
+      SmallVector<std::pair<serialization::DeclID, CharUnits>, 4> Bases;
+      for (const auto &Base : CXXInfo->BaseOffsets)
+        Bases.push_back({getLayoutDeclID(Base.first), Base.second});
+      llvm::sort(Bases.begin(), Bases.end(), llvm::less_first());
+      SmallVector<std::pair<serialization::DeclID,
+                            ASTRecordLayout::VBaseInfo>, 4> VBases;
+      for (const auto &VBase : CXXInfo->VBaseOffsets)
+        VBases.push_back({getLayoutDeclID(VBase.first), VBase.second});
+      llvm::sort(VBases.begin(), VBases.end(), llvm::less_first());
+      if ((!Bases.empty() && !Bases.front().first) ||
+          (!VBases.empty() && !VBases.front().first))
+        continue;
+
+      Entry.push_back(CXXInfo->NonVirtualSize.getQuantity());
+      Entry.push_back(CXXInfo->NonVirtualAlignment.getQuantity());
+      Entry.push_back(CXXInfo->SizeOfLargestEmptySubobject.getQuantity());
+      Entry.push_back(CXXInfo->VBPtrOffset.getQuantity());
+      Entry.push_back(CXXInfo->HasOwnVFPtr);
+      Entry.push_back(CXXInfo->HasExtendableVFPtr);
+      Entry.push_back(CXXInfo->EndsWithZeroSizedObject);
+      Entry.push_back(CXXInfo->LeadsWithZeroSizedBase);
+      Entry.push_back(PrimaryBaseID);
+      Entry.push_back(CXXInfo->PrimaryBase.getInt());
+      Entry.push_back(BaseSharingVBPtrID);
+      Entry.push_back(Bases.size());
+      for (const auto &Base : Bases) {
+        Entry.push_back(Base.first);
+        Entry.push_back(Base.second.getQuantity());
+      }
+      Entry.push_back(VBases.size());
+      for (const auto &VBase : VBases) {
+        Entry.push_back(VBase.first);
+        Entry.push_back(VBase.second.VBaseOffset.getQuantity());
+        Entry.push_back(VBase.second.hasVtorDisp());
+      }
+    }
+
+    Record.push_back(getDeclID(RD));
+    Record.push_back(Entry.size());
+    Record.append(Entry.begin(), Entry.end());
+  }
+  Stream.EmitRecord(RECORD_LAYOUTS, Record);
+}
+
 void ASTWriter::WriteObjCCategories() {
   SmallVector<ObjCCategoriesInfo, 2> CategoriesMap;
   RecordData Categories;
@@ -4979,6 +5067,8 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
   } while (!DeclUpdates.empty());
   Stream.ExitBlock();
 
+  WriteRecordLayouts(Context);
+
   DoneWritingDeclsAndTypes = true;
 
   // These things can only be done once we've written out decls and types.
@@ -472,6 +472,11 @@ void ASTDeclWriter::VisitRecordDecl(RecordDecl *D) {
   Record.push_back(D->isParamDestroyedInCallee());
   Record.push_back(D->getArgPassingRestrictions());
 
+  if (Writer.Context->getLangOpts().ModulesRecordLayouts &&
+      D->isThisDeclarationADefinition() && !D->isDependentType() &&
+      !D->isInvalidDecl())
+    Writer.RecordsToLayOut.push_back(D);
+
   if (D->getDeclContext() == D->getLexicalDeclContext() &&
       !D->hasAttrs() &&
       !D->isImplicit() &&
@@ -19,8 +19,10 @@
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Serialization/Module.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/DJB.h"
@@ -33,6 +35,13 @@
 using namespace clang;
 using namespace serialization;
 
+#define DEBUG_TYPE "global-module-index"
+
+STATISTIC(NumModuleFilesReused,
+          "The # of module files carried over from the previous index");
+STATISTIC(NumModuleFilesRead,
+          "The # of module files read to build the index");
+
 //----------------------------------------------------------------------------//
 // Shared constants
 //----------------------------------------------------------------------------//
@@ -58,7 +67,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -189,6 +198,10 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
       Modules[ID].Size = Record[Idx++];
       Modules[ID].ModTime = Record[Idx++];
 
+      // Signature of this module file, or zero.
+      for (unsigned I = 0; I != 5; ++I)
+        Modules[ID].Signature[I] = (uint32_t)Record[Idx++];
+
       // File name.
       unsigned NameLen = Record[Idx++];
       Modules[ID].FileName.assign(Record.begin() + Idx,
@@ -440,6 +453,25 @@ namespace {
     /// \returns true if an error occurred, false otherwise.
     bool loadModuleFile(const FileEntry *File);
 
+    /// Record a module file whose contents are known from a previous
+    /// version of the index, without reading the module file itself.
+    void addIndexedModuleFile(const FileEntry *File,
+                              const ASTFileSignature &Signature,
+                              ArrayRef<const FileEntry *> Dependencies) {
+      ModuleFileInfo &Info = getModuleFileInfo(File);
+      Info.Signature = Signature;
+      for (const FileEntry *Dep : Dependencies)
+        Info.Dependencies.push_back(getModuleFileInfo(Dep).ID);
+    }
+
+    /// Record that \p Name is known to the index, and interesting in
+    /// \p File if it is non-null.
+    void addIndexedIdentifier(StringRef Name, const FileEntry *File) {
+      SmallVector<unsigned, 2> &IDs = InterestingIdentifiers[Name];
+      if (File)
+        IDs.push_back(getModuleFileInfo(File).ID);
+    }
+
     /// Write the index to the given bitstream.
     /// \returns true if an error occurred, false otherwise.
     bool writeIndex(llvm::BitstreamWriter &Stream);
@@ -766,6 +798,7 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Record.push_back(M->second.ID);
     Record.push_back(M->first->getSize());
     Record.push_back(M->first->getModificationTime());
+    Record.append(M->second.Signature.begin(), M->second.Signature.end());
 
     // File name
     StringRef Name(M->first->getName());
@@ -845,7 +878,8 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
   // The module index builder.
   GlobalModuleIndexBuilder Builder(FileMgr, PCHContainerRdr);
 
-  // Load each of the module files.
+  // Collect the module files.
+  SmallVector<const FileEntry *, 16> ModuleFiles;
   std::error_code EC;
   for (llvm::sys::fs::directory_iterator D(Path, EC), DEnd;
        D != DEnd && !EC;
@@ -862,13 +896,92 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
     }
 
     // If we can't find the module file, skip it.
-    const FileEntry *ModuleFile = FileMgr.getFile(D->path());
-    if (!ModuleFile)
-      continue;
+    if (const FileEntry *ModuleFile = FileMgr.getFile(D->path()))
+      ModuleFiles.push_back(ModuleFile);
+  }
+
+  // Carry over what the existing index knows about module files that have
+  // not changed since it was written.
+  llvm::DenseSet<const FileEntry *> Reused;
+  std::unique_ptr<GlobalModuleIndex> OldIndex(readIndex(Path).first);
+  if (OldIndex && OldIndex->IdentifierIndex) {
+    llvm::DenseSet<const FileEntry *> Present(ModuleFiles.begin(),
+                                              ModuleFiles.end());
+
+    // Find the module files whose size and modification time match the ones
+    // recorded in the existing index.
+    ArrayRef<ModuleInfo> OldModules = OldIndex->Modules;
+    SmallVector<const FileEntry *, 16> OldFiles(OldModules.size());
+    for (unsigned ID = 0, N = OldModules.size(); ID != N; ++ID) {
+      const ModuleInfo &Info = OldModules[ID];
+      if (Info.FileName.empty())
+        continue;
+      const FileEntry *File = FileMgr.getFile(Info.FileName,
+                                              /*openFile=*/false,
+                                              /*cacheFailure=*/false);
+      if (File && Present.count(File) && File->getSize() == Info.Size &&
+          File->getModificationTime() == Info.ModTime)
+        OldFiles[ID] = File;
+    }
 
-    // Load this module file.
+    // A module file can only be carried over if everything it depends on
+    // can be too; otherwise it is out of date and must be read again.
+    bool Changed = true;
+    while (Changed) {
+      Changed = false;
+      for (unsigned ID = 0, N = OldModules.size(); ID != N; ++ID) {
+        if (!OldFiles[ID])
+          continue;
+        for (unsigned Dep : OldModules[ID].Dependencies) {
+          if (Dep >= N || !OldFiles[Dep]) {
+            OldFiles[ID] = nullptr;
+            Changed = true;
+            break;
+          }
+        }
+      }
+    }
+
+    for (unsigned ID = 0, N = OldModules.size(); ID != N; ++ID) {
+      if (!OldFiles[ID])
+        continue;
+      SmallVector<const FileEntry *, 4> Deps;
+      for (unsigned Dep : OldModules[ID].Dependencies)
+        Deps.push_back(OldFiles[Dep]);
+      Builder.addIndexedModuleFile(OldFiles[ID], OldModules[ID].Signature,
+                                   Deps);
+      Reused.insert(OldFiles[ID]);
+      ++NumModuleFilesReused;
+    }
+
+    // Carry over the identifiers of the reused module files.
+    IdentifierIndexTable &Table =
+        *static_cast<IdentifierIndexTable *>(OldIndex->IdentifierIndex);
+    for (IdentifierIndexTable::key_iterator K = Table.key_begin(),
+                                            KEnd = Table.key_end();
+         K != KEnd; ++K) {
+      SmallVector<unsigned, 2> ModuleIDs = *Table.find(*K);
+      if (ModuleIDs.empty()) {
+        Builder.addIndexedIdentifier(*K, nullptr);
+        continue;
+      }
+      for (unsigned ID : ModuleIDs)
+        if (ID < OldFiles.size() && OldFiles[ID])
+          Builder.addIndexedIdentifier(*K, OldFiles[ID]);
+    }
+  }
+
+  // The builder has copied everything it needs. Release the old index, which
+  // maps the file that is about to be replaced.
+  OldIndex.reset();
+
+  // Load each of the remaining module files.
+  for (const FileEntry *ModuleFile : ModuleFiles) {
+    if (Reused.count(ModuleFile))
+      continue;
     if (Builder.loadModuleFile(ModuleFile))
       return EC_IOError;
+    ++NumModuleFilesRead;
   }
 
   // The output buffer, into which the global index will be written.
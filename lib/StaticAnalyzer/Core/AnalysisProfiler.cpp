@@ -0,0 +1,197 @@
+//===- AnalysisProfiler.cpp - Cost of checkers and functions ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines AnalysisProfiler, which records how much time and how
+//  many exploded nodes the path-sensitive analysis spends in each checker,
+//  each top-level function and each inlined callee.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/StaticAnalyzer/Core/AnalysisProfiler.h"
+#include "clang/StaticAnalyzer/Core/Checker.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+void AnalysisProfiler::CheckerScope::enter() {
+  Parent = Profiler->ActiveScope;
+  Profiler->ActiveScope = this;
+  NestedSeconds = 0;
+  NestedNodes = 0;
+  StartNodes = G ? G->size() : 0;
+  Start = Clock::now();
+}
+
+void AnalysisProfiler::CheckerScope::exit() {
+  double Seconds = secondsSince(Start);
+  uint64_t Nodes = 0;
+  // Nodes may be reclaimed while the checker runs, so the graph can shrink.
+  if (G && G->size() > StartNodes)
+    Nodes = G->size() - StartNodes;
+
+  Cost &C = Profiler->CheckerCosts[Checker];
+  C.Seconds += std::max(Seconds - NestedSeconds, 0.0);
+  C.Nodes += Nodes > NestedNodes ? Nodes - NestedNodes : 0;
+  C.Count += NumCalls;
+
+  Profiler->ActiveScope = Parent;
+  if (Parent) {
+    Parent->NestedSeconds += Seconds;
+    Parent->NestedNodes += Nodes;
+  }
+}
+
+void AnalysisProfiler::addFunctionCost(const Decl *D, double Seconds,
+                                       uint64_t Nodes) {
+  Cost &C = FunctionCosts[D];
+  C.Seconds += Seconds;
+  C.Nodes += Nodes;
+  ++C.Count;
+}
+
+void AnalysisProfiler::addCalleeCost(const Decl *D, double Seconds,
+                                     uint64_t Nodes) {
+  CalleeCost &C = CalleeCosts[D];
+  C.Seconds += Seconds;
+  C.Nodes += Nodes;
+  ++C.Count;
+}
+
+void AnalysisProfiler::recordInlining(const Decl *D, bool Inlined) {
+  CalleeCost &C = CalleeCosts[D];
+  if (Inlined)
+    ++C.NumInlined;
+  else
+    ++C.NumNotInlined;
+}
+
+static std::string getCheckerName(const CheckerBase *Checker) {
+  StringRef Name = Checker->getTagDescription();
+  return Name.empty() ? "<unnamed checker>" : Name.str();
+}
+
+/// Returns the entries of \p Costs in the order of decreasing time.
+template <typename KeyTy, typename CostTy>
+static SmallVector<const std::pair<KeyTy, CostTy> *, 32>
+sortByTime(const llvm::MapVector<KeyTy, CostTy> &Costs) {
+  SmallVector<const std::pair<KeyTy, CostTy> *, 32> Sorted;
+  for (const auto &Entry : Costs)
+    Sorted.push_back(&Entry);
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const std::pair<KeyTy, CostTy> *LHS,
+                      const std::pair<KeyTy, CostTy> *RHS) {
+                     return LHS->second.Seconds > RHS->second.Seconds;
+                   });
+  return Sorted;
+}
+
+void AnalysisProfiler::printTable(
+    raw_ostream &OS,
+    llvm::function_ref<std::string(const Decl *)> GetName) const {
+  OS << "===-------------------------------------------------------------===\n"
+     << "  Analyzer checker costs, excluding nested checker callbacks\n"
+     << "===-------------------------------------------------------------===\n"
+     << "    Time (s)       Nodes       Calls  Checker\n";
+  for (const auto *Entry : sortByTime(CheckerCosts)) {
+    const Cost &C = Entry->second;
+    OS << llvm::format("%12.6f%12llu%12llu  ", C.Seconds,
+                       (unsigned long long)C.Nodes,
+                       (unsigned long long)C.Count)
+       << getCheckerName(Entry->first) << '\n';
+  }
+
+  OS << "===-------------------------------------------------------------===\n"
+     << "  Analyzer top-level function costs\n"
+     << "===-------------------------------------------------------------===\n"
+     << "    Time (s)       Nodes    Analyses  Function\n";
+  for (const auto *Entry : sortByTime(FunctionCosts)) {
+    const Cost &C = Entry->second;
+    OS << llvm::format("%12.6f%12llu%12llu  ", C.Seconds,
+                       (unsigned long long)C.Nodes,
+                       (unsigned long long)C.Count)
+       << GetName(Entry->first) << '\n';
+  }
+
+  OS << "===-------------------------------------------------------------===\n"
+     << "  Analyzer inlined callee costs\n"
+     << "===-------------------------------------------------------------===\n"
+     << "    Time (s)       Nodes       Steps     Inlined Not inlined"
+     << "  Callee\n";
+  for (const auto *Entry : sortByTime(CalleeCosts)) {
+    const CalleeCost &C = Entry->second;
+    OS << llvm::format("%12.6f%12llu%12llu%12llu%12llu  ", C.Seconds,
+                       (unsigned long long)C.Nodes,
+                       (unsigned long long)C.Count,
+                       (unsigned long long)C.NumInlined,
+                       (unsigned long long)C.NumNotInlined)
+       << GetName(Entry->first) << '\n';
+  }
+}
+
+static void printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << llvm::format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+static void printJSONCost(raw_ostream &OS, StringRef Name,
+                          const AnalysisProfiler::Cost &C,
+                          StringRef CountName) {
+  OS << "{\"name\": ";
+  printJSONString(OS, Name);
+  OS << llvm::format(", \"seconds\": %.6f", C.Seconds)
+     << ", \"nodes\": " << C.Nodes
+     << ", \"" << CountName << "\": " << C.Count;
+}
+
+void AnalysisProfiler::printJSON(
+    raw_ostream &OS,
+    llvm::function_ref<std::string(const Decl *)> GetName) const {
+  OS << "{\n  \"checkers\": [";
+  const char *Sep = "\n";
+  for (const auto *Entry : sortByTime(CheckerCosts)) {
+    OS << Sep << "    ";
+    printJSONCost(OS, getCheckerName(Entry->first), Entry->second, "calls");
+    OS << '}';
+    Sep = ",\n";
+  }
+
+  OS << "\n  ],\n  \"functions\": [";
+  Sep = "\n";
+  for (const auto *Entry : sortByTime(FunctionCosts)) {
+    OS << Sep << "    ";
+    printJSONCost(OS, GetName(Entry->first), Entry->second, "analyses");
+    OS << '}';
+    Sep = ",\n";
+  }
+
+  OS << "\n  ],\n  \"callees\": [";
+  Sep = "\n";
+  for (const auto *Entry : sortByTime(CalleeCosts)) {
+    const CalleeCost &C = Entry->second;
+    OS << Sep << "    ";
+    printJSONCost(OS, GetName(Entry->first), C, "steps");
+    OS << ", \"inlined\": " << C.NumInlined
+       << ", \"not-inlined\": " << C.NumNotInlined << '}';
+    Sep = ",\n";
+  }
+  OS << "\n  ]\n}\n";
+}
@@ -21,6 +21,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <utility>
@@ -79,6 +80,7 @@ AnalyzerOptions::getExplorationStrategy() {
                   ExplorationStrategyKind::UnexploredFirstQueue)
             .Case("bfs_block_dfs_contents",
                   ExplorationStrategyKind::BFSBlockDFSContents)
+            .Case("interleaved_dfs", ExplorationStrategyKind::InterleavedDFS)
             .Default(ExplorationStrategyKind::NotSet);
     assert(ExplorationStrategy != ExplorationStrategyKind::NotSet &&
            "User mode is invalid.");
@@ -382,6 +384,16 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  return getBooleanOption(AggressiveGraphTrimming, "aggressive-graph-trimming",
+                          /*Default=*/false);
+}
+
+bool AnalyzerOptions::shouldBatchReportGraphs() {
+  return getBooleanOption(BatchReportGraphs, "batch-report-graphs",
+                          /*Default=*/false);
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -414,6 +426,22 @@ unsigned AnalyzerOptions::getMaxNodesPerTopLevelFunction() {
   return MaxNodesPerTopLevelFunction.getValue();
 }
 
+unsigned AnalyzerOptions::getAnalysisShardCount() {
+  if (!AnalysisShardCount.hasValue())
+    AnalysisShardCount =
+        std::max(getOptionAsInteger("analysis-shard-count", 1), 1);
+  return AnalysisShardCount.getValue();
+}
+
+unsigned AnalyzerOptions::getAnalysisShardIndex() {
+  if (!AnalysisShardIndex.hasValue()) {
+    AnalysisShardIndex = getOptionAsInteger("analysis-shard-index", 0);
+    assert(*AnalysisShardIndex < getAnalysisShardCount() &&
+           "shard index should have been checked by the frontend");
+  }
+  return AnalysisShardIndex.getValue();
+}
+
 bool AnalyzerOptions::shouldSynthesizeBodies() {
   return getBooleanOption("faux-bodies", true);
 }
@@ -468,6 +496,27 @@ StringRef AnalyzerOptions::getCTUDir() {
   return CTUDir.getValue();
 }
 
+StringRef AnalyzerOptions::getIncrementalCacheDir() {
+  if (!IncrementalCacheDir.hasValue()) {
+    IncrementalCacheDir = getOptionAsString("incremental-cache-dir", "");
+    if (!llvm::sys::fs::is_directory(*IncrementalCacheDir))
+      IncrementalCacheDir = "";
+  }
+  return IncrementalCacheDir.getValue();
+}
+
+bool AnalyzerOptions::shouldProfileAnalysis() {
+  if (!ProfileAnalysis.hasValue())
+    ProfileAnalysis = getBooleanOption("profile-analysis", /*Default=*/false);
+  return ProfileAnalysis.getValue();
+}
+
+StringRef AnalyzerOptions::getAnalysisProfileOutput() {
+  if (!AnalysisProfileOutput.hasValue())
+    AnalysisProfileOutput = getOptionAsString("profile-analysis-output", "");
+  return AnalysisProfileOutput.getValue();
+}
+
 bool AnalyzerOptions::naiveCTUEnabled() {
   if (!NaiveCTU.hasValue()) {
     NaiveCTU = getBooleanOption("experimental-enable-naive-ctu-analysis",
@@ -481,3 +530,16 @@ StringRef AnalyzerOptions::getCTUIndexName() {
     CTUIndexName = getOptionAsString("ctu-index-name", "externalFnMap.txt");
   return CTUIndexName.getValue();
 }
+
+unsigned AnalyzerOptions::getCTUMaxLoadedASTMemory() {
+  if (!CTUMaxLoadedASTMemory.hasValue())
+    CTUMaxLoadedASTMemory = getOptionAsInteger("ctu-max-loaded-ast-memory", 0);
+  return CTUMaxLoadedASTMemory.getValue();
+}
+
+bool AnalyzerOptions::shouldLookupCTUDefinitionsLazily() {
+  if (!CTULazyDefinitionLookup.hasValue())
+    CTULazyDefinitionLookup =
+        getBooleanOption("ctu-lazy-definition-lookup", /*Default=*/false);
+  return CTULazyDefinitionLookup.getValue();
+}
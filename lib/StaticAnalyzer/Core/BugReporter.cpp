@@ -39,6 +39,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/MemRegion.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/SMTConstraintManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SVals.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SymbolManager.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -80,6 +81,11 @@ STATISTIC(MaxBugClassSize,
 STATISTIC(MaxValidBugClassSize,
           "The maximum number of bug reports in the same equivalence class "
           "where at least one report is valid (not suppressed)");
+STATISTIC(NumReportGraphTrims,
+          "The # of times the exploded graph was trimmed to generate paths");
+STATISTIC(NumSharedReportGraphs,
+          "The # of paths generated from a graph trimmed once for all the "
+          "reports of a function");
 
 BugReporterVisitor::~BugReporterVisitor() = default;
 
@@ -2175,6 +2181,8 @@ BugReportEquivClass::~BugReportEquivClass() = default;
 
 GRBugReporter::~GRBugReporter() = default;
 
+void GRBugReporter::clearReportGraphs() { SharedTrimmedGraph.reset(); }
+
 BugReporterData::~BugReporterData() = default;
 
 ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
@@ -2182,6 +2190,17 @@ ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
 ProgramStateManager&
 GRBugReporter::getStateManager() { return Eng.getStateManager(); }
 
+SMTConstraintManager &GRBugReporter::getRefutationManager() {
+  if (!RefutationMgr) {
+    std::unique_ptr<ConstraintManager> Mgr =
+        CreateZ3ConstraintManager(getStateManager(), &Eng);
+    RefutationMgr.reset(static_cast<SMTConstraintManager *>(Mgr.release()));
+  } else {
+    RefutationMgr->resetConstraints();
+  }
+  return *RefutationMgr;
+}
+
 BugReporter::~BugReporter() {
   FlushReports();
 
@@ -2206,6 +2225,7 @@ void BugReporter::FlushReports() {
   // of the reports is consistent between runs.
   for (const auto EQ : EQClassesVector)
     FlushReport(*EQ);
+  clearReportGraphs();
 
   // BugReporter owns and deletes only BugTypes created implicitly through
   // EmitBasicReport.
@@ -2221,7 +2241,8 @@ void BugReporter::FlushReports() {
 // PathDiagnostics generation.
 //===----------------------------------------------------------------------===//
 
-namespace {
+namespace clang {
+namespace ento {
 
 /// A wrapper around a report graph, which contains only a single path, and its
 /// node maps.
@@ -2235,18 +2256,19 @@ public:
 
 /// A wrapper around a trimmed graph and its node maps.
 class TrimmedGraph {
+  InterExplodedGraphMap ForwardMap;
   InterExplodedGraphMap InverseMap;
 
   using PriorityMapTy = llvm::DenseMap<const ExplodedNode *, unsigned>;
 
   PriorityMapTy PriorityMap;
 
-  using NodeIndexPair = std::pair<const ExplodedNode *, size_t>;
-
-  SmallVector<NodeIndexPair, 32> ReportNodes;
-
   std::unique_ptr<ExplodedGraph> G;
 
+public:
+  using NodeIndexPair = std::pair<const ExplodedNode *, size_t>;
+
+private:
   /// A helper class for sorting ExplodedNodes by priority.
   template <bool Descending>
   class PriorityCompare {
@@ -2278,29 +2300,37 @@ public:
   TrimmedGraph(const ExplodedGraph *OriginalGraph,
                ArrayRef<const ExplodedNode *> Nodes);
 
-  bool popNextReportGraph(ReportGraph &GraphWrapper);
+  /// Find the error nodes \p Nodes of the original graph in the trimmed
+  /// graph, sorted from the longest to the shortest path, along with their
+  /// index in \p Nodes.
+  ///
+  /// \return False if some of the nodes are not in the trimmed graph.
+  bool getReportNodes(ArrayRef<const ExplodedNode *> Nodes,
+                      SmallVectorImpl<NodeIndexPair> &ReportNodes) const;
+
+  /// Create a graph with the shortest path from the root to the error node
+  /// \p ReportNode of the trimmed graph.
+  void createReportGraph(NodeIndexPair ReportNode,
+                         ReportGraph &GraphWrapper) const;
 };
 
-} // namespace
+} // namespace ento
+} // namespace clang
 
 TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
                            ArrayRef<const ExplodedNode *> Nodes) {
   // The trimmed graph is created in the body of the constructor to ensure
   // that the DenseMaps have been initialized already.
-  InterExplodedGraphMap ForwardMap;
   G = OriginalGraph->trim(Nodes, &ForwardMap, &InverseMap);
 
-  // Find the (first) error node in the trimmed graph.  We just need to consult
+  // Find the error nodes in the trimmed graph.  We just need to consult
   // the node map which maps from nodes in the original graph to nodes
   // in the new graph.
   llvm::SmallPtrSet<const ExplodedNode *, 32> RemainingNodes;
 
-  for (unsigned i = 0, count = Nodes.size(); i < count; ++i) {
-    if (const ExplodedNode *NewNode = ForwardMap.lookup(Nodes[i])) {
-      ReportNodes.push_back(std::make_pair(NewNode, i));
+  for (const ExplodedNode *Node : Nodes)
+    if (const ExplodedNode *NewNode = ForwardMap.lookup(Node))
       RemainingNodes.insert(NewNode);
-    }
-  }
 
   assert(!RemainingNodes.empty() && "No error node found in the trimmed graph");
 
@@ -2335,18 +2365,30 @@ TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
          I != E; ++I)
       WS.push(*I);
   }
+}
+
+bool TrimmedGraph::getReportNodes(
+    ArrayRef<const ExplodedNode *> Nodes,
+    SmallVectorImpl<NodeIndexPair> &ReportNodes) const {
+  for (unsigned i = 0, count = Nodes.size(); i < count; ++i) {
+    if (!Nodes[i])
+      continue;
+    const ExplodedNode *NewNode = ForwardMap.lookup(Nodes[i]);
+    if (!NewNode)
+      return false;
+    ReportNodes.push_back(std::make_pair(NewNode, i));
+  }
 
   // Sort the error paths from longest to shortest.
   llvm::sort(ReportNodes.begin(), ReportNodes.end(),
              PriorityCompare<true>(PriorityMap));
+  return true;
 }
 
-bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
-  if (ReportNodes.empty())
-    return false;
-
+void TrimmedGraph::createReportGraph(NodeIndexPair ReportNode,
+                                     ReportGraph &GraphWrapper) const {
   const ExplodedNode *OrigN;
-  std::tie(OrigN, GraphWrapper.Index) = ReportNodes.pop_back_val();
+  std::tie(OrigN, GraphWrapper.Index) = ReportNode;
   assert(PriorityMap.find(OrigN) != PriorityMap.end() &&
          "error node not accessible from root");
 
@@ -2390,8 +2432,6 @@ bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
   }
 
   GraphWrapper.Graph = std::move(GNew);
-
-  return true;
 }
 
 /// CompactPathDiagnostic - This function postprocesses a PathDiagnostic object
@@ -2515,10 +2555,43 @@ bool GRBugReporter::generatePathDiagnostic(PathDiagnostic& PD,
 
   PathGenerationScheme ActiveScheme = PC.getGenerationScheme();
 
-  TrimmedGraph TrimG(&getGraph(), errorNodes);
+  // Share the trimmed graph between all the reports of the function, if
+  // requested. Reports emitted after it was trimmed need a graph of their own.
+  std::unique_ptr<TrimmedGraph> LocalTrimmedGraph;
+  const TrimmedGraph *TrimG = nullptr;
+  SmallVector<TrimmedGraph::NodeIndexPair, 32> ReportNodes;
+  if (getAnalyzerOptions().shouldBatchReportGraphs()) {
+    if (!SharedTrimmedGraph) {
+      SmallVector<const ExplodedNode *, 32> AllErrorNodes;
+      for (auto I = EQClasses_begin(), E = EQClasses_end(); I != E; ++I)
+        for (BugReport &Report : *I)
+          if (const ExplodedNode *N = Report.getErrorNode())
+            AllErrorNodes.push_back(N);
+      SharedTrimmedGraph =
+          llvm::make_unique<TrimmedGraph>(&getGraph(), AllErrorNodes);
+      ++NumReportGraphTrims;
+    }
+    if (SharedTrimmedGraph->getReportNodes(errorNodes, ReportNodes)) {
+      TrimG = SharedTrimmedGraph.get();
+      ++NumSharedReportGraphs;
+    } else {
+      ReportNodes.clear();
+    }
+  }
+  if (!TrimG) {
+    LocalTrimmedGraph =
+        llvm::make_unique<TrimmedGraph>(&getGraph(), errorNodes);
+    bool FoundAll = LocalTrimmedGraph->getReportNodes(errorNodes, ReportNodes);
+    assert(FoundAll && "Error node missing from the trimmed graph");
+    (void)FoundAll;
+    TrimG = LocalTrimmedGraph.get();
+    ++NumReportGraphTrims;
+  }
+
   ReportGraph ErrorGraph;
+  while (!ReportNodes.empty()) {
+    TrimG->createReportGraph(ReportNodes.pop_back_val(), ErrorGraph);
 
-  while (TrimG.popNextReportGraph(ErrorGraph)) {
     // Find the BugReport with the original location.
     assert(ErrorGraph.Index < bugReports.size());
     BugReport *R = bugReports[ErrorGraph.Index];
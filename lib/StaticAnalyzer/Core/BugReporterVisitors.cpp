@@ -2359,19 +2359,16 @@ TaintBugVisitor::VisitNode(const ExplodedNode *N, const ExplodedNode *PrevN,
 static bool
 areConstraintsUnfeasible(BugReporterContext &BRC,
                          const llvm::SmallVector<ConstraintRangeTy, 32> &Cs) {
-  // Create a refutation manager
-  std::unique_ptr<ConstraintManager> RefutationMgr = CreateZ3ConstraintManager(
-      BRC.getStateManager(), BRC.getStateManager().getOwningEngine());
-
-  SMTConstraintManager *SMTRefutationMgr =
-      static_cast<SMTConstraintManager *>(RefutationMgr.get());
+  // Reuse the refutation manager of the bug reporter
+  SMTConstraintManager &RefutationMgr =
+      BRC.getBugReporter().getRefutationManager();
 
   // Add constraints to the solver
   for (const auto &C : Cs)
-    SMTRefutationMgr->addRangeConstraints(C);
+    RefutationMgr.addRangeConstraints(C);
 
   // And check for satisfiability
-  return SMTRefutationMgr->isModelFeasible().isConstrainedFalse();
+  return RefutationMgr.isModelFeasible().isConstrainedFalse();
 }
 
 std::shared_ptr<PathDiagnosticPiece>
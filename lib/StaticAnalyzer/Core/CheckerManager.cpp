@@ -16,6 +16,7 @@
 #include "clang/AST/Stmt.h"
 #include "clang/Analysis/ProgramPoint.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/AnalysisProfiler.h"
 #include "clang/StaticAnalyzer/Core/Checker.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
@@ -81,16 +82,20 @@ void CheckerManager::runCheckersOnASTDecl(const Decl *D, AnalysisManager& mgr,
   }
 
   assert(checkers);
-  for (const auto checker : *checkers)
+  for (const auto checker : *checkers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler, checker.Checker);
     checker(D, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
                                           BugReporter &BR) {
   assert(D && D->hasBody());
 
-  for (const auto BodyChecker : BodyCheckers)
+  for (const auto BodyChecker : BodyCheckers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler, BodyChecker.Checker);
     BodyChecker(D, mgr, BR);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -114,6 +119,7 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
 
   ExplodedNodeSet Tmp1, Tmp2;
   const ExplodedNodeSet *PrevSet = &Src;
+  AnalysisProfiler *Profiler = checkCtx.Eng.getCheckerManager().getProfiler();
 
   for (; I != E; ++I) {
     ExplodedNodeSet *CurrSet = nullptr;
@@ -125,8 +131,13 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     }
 
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
-    for (const auto &NI : *PrevSet)
-      checkCtx.runChecker(*I, B, NI);
+    {
+      AnalysisProfiler::CheckerScope Scope(Profiler, I->Checker,
+                                           &checkCtx.Eng.getGraph(),
+                                           PrevSet->size());
+      for (const auto &NI : *PrevSet)
+        checkCtx.runChecker(*I, B, NI);
+    }
 
     // If all the produced transitions are sinks, stop.
     if (CurrSet->empty())
@@ -392,8 +403,11 @@ void CheckerManager::runCheckersForBind(ExplodedNodeSet &Dst,
 void CheckerManager::runCheckersForEndAnalysis(ExplodedGraph &G,
                                                BugReporter &BR,
                                                ExprEngine &Eng) {
-  for (const auto EndAnalysisChecker : EndAnalysisCheckers)
+  for (const auto EndAnalysisChecker : EndAnalysisCheckers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler, EndAnalysisChecker.Checker,
+                                         &G);
     EndAnalysisChecker(G, BR, Eng);
+  }
 }
 
 namespace {
@@ -445,6 +459,8 @@ void CheckerManager::runCheckersForEndFunction(NodeBuilderContext &BC,
   // autotransition for it.
   NodeBuilder Bldr(Pred, Dst, BC);
   for (const auto checkFn : EndFunctionCheckers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler, checkFn.Checker,
+                                         &Eng.getGraph());
     const ProgramPoint &L = BlockEntrance(BC.Block,
                                           Pred->getLocationContext(),
                                           checkFn.Checker);
@@ -532,8 +548,10 @@ void CheckerManager::runCheckersForNewAllocator(
 /// Run checkers for live symbols.
 void CheckerManager::runCheckersForLiveSymbols(ProgramStateRef state,
                                                SymbolReaper &SymReaper) {
-  for (const auto LiveSymbolsChecker : LiveSymbolsCheckers)
+  for (const auto LiveSymbolsChecker : LiveSymbolsCheckers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler, LiveSymbolsChecker.Checker);
     LiveSymbolsChecker(state, SymReaper);
+  }
 }
 
 namespace {
@@ -594,6 +612,8 @@ CheckerManager::runCheckersForRegionChanges(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    AnalysisProfiler::CheckerScope Scope(Profiler,
+                                         RegionChangesChecker.Checker);
     state = RegionChangesChecker(state, invalidated, ExplicitRegions, Regions,
                                  LCtx, Call);
   }
@@ -616,6 +636,8 @@ CheckerManager::runCheckersForPointerEscape(ProgramStateRef State,
     //  way), bail out.
     if (!State)
       return nullptr;
+    AnalysisProfiler::CheckerScope Scope(Profiler,
+                                         PointerEscapeChecker.Checker);
     State = PointerEscapeChecker(State, Escaped, Call, Kind, ETraits);
   }
   return State;
@@ -630,6 +652,7 @@ CheckerManager::runCheckersForEvalAssume(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    AnalysisProfiler::CheckerScope Scope(Profiler, EvalAssumeChecker.Checker);
     state = EvalAssumeChecker(state, Cond, Assumption);
   }
   return state;
@@ -658,6 +681,8 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        AnalysisProfiler::CheckerScope Scope(Profiler, EvalCallChecker.Checker,
+                                             &Eng.getGraph());
         CheckerContext C(B, Eng, Pred, L);
         evaluated = EvalCallChecker(CE, C);
       }
@@ -685,8 +710,11 @@ void CheckerManager::runCheckersOnEndOfTranslationUnit(
                                                   const TranslationUnitDecl *TU,
                                                   AnalysisManager &mgr,
                                                   BugReporter &BR) {
-  for (const auto EndOfTranslationUnitChecker : EndOfTranslationUnitCheckers)
+  for (const auto EndOfTranslationUnitChecker : EndOfTranslationUnitCheckers) {
+    AnalysisProfiler::CheckerScope Scope(Profiler,
+                                         EndOfTranslationUnitChecker.Checker);
     EndOfTranslationUnitChecker(TU, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
@@ -21,7 +21,10 @@
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/ProgramPoint.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/AnalysisProfiler.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "clang/StaticAnalyzer/Core/CheckerManager.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/BlockCounter.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
@@ -65,6 +68,8 @@ static std::unique_ptr<WorkList> generateWorkList(AnalyzerOptions &Opts) {
       return WorkList::makeUnexploredFirst();
     case AnalyzerOptions::ExplorationStrategyKind::UnexploredFirstQueue:
       return WorkList::makeUnexploredFirstPriorityQueue();
+    case AnalyzerOptions::ExplorationStrategyKind::InterleavedDFS:
+      return WorkList::makeInterleavedDFS();
     default:
       llvm_unreachable("Unexpected case");
   }
@@ -125,6 +130,9 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
   if(!UnlimitedSteps)
     G.reserve(std::min(Steps,PreReservationCap));
 
+  AnalysisProfiler *Profiler =
+      SubEng.getAnalysisManager().getCheckerManager()->getProfiler();
+
   while (WList->hasWork()) {
     if (!UnlimitedSteps) {
       if (Steps == 0) {
@@ -144,7 +152,22 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
     // Retrieve the node.
     ExplodedNode *Node = WU.getNode();
 
+    // Attribute the work done in the stack frames of inlined calls to the
+    // callee.
+    const StackFrameContext *SFC =
+        Profiler ? Node->getLocationContext()->getCurrentStackFrame() : nullptr;
+    if (!SFC || !SFC->getParent()) {
+      dispatchWorkItem(Node, Node->getLocation(), WU);
+      continue;
+    }
+
+    unsigned NodesBefore = G.size();
+    AnalysisProfiler::Clock::time_point Start = AnalysisProfiler::Clock::now();
     dispatchWorkItem(Node, Node->getLocation(), WU);
+    Profiler->addCalleeCost(SFC->getDecl(),
+                            AnalysisProfiler::secondsSince(Start),
+                            G.size() > NodesBefore ? G.size() - NodesBefore
+                                                   : 0);
   }
   SubEng.processEndWorklist(hasWorkRemaining());
   return WList->hasWork();
@@ -28,6 +28,7 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
 #include <cassert>
 #include <memory>
@@ -35,6 +36,12 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ExplodedGraph"
+
+STATISTIC(NumReclaimedNodes, "The # of nodes reclaimed");
+STATISTIC(NumReclaimedFrontierNodes,
+          "The # of nodes reclaimed after being on the frontier");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -197,9 +204,27 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
     return;
   ReclaimCounter = ReclaimNodeInterval;
 
-  for (const auto node : ChangedNodes)
-    if (shouldCollect(node))
+  // Nodes that were on the frontier last time have had a whole interval to
+  // get their successor. Give them their second and last chance.
+  for (const auto node : FrontierNodes)
+    if (shouldCollect(node)) {
+      collectNode(node);
+      ++NumReclaimedNodes;
+      ++NumReclaimedFrontierNodes;
+    }
+  FrontierNodes.clear();
+
+  for (const auto node : ChangedNodes) {
+    if (shouldCollect(node)) {
       collectNode(node);
+      ++NumReclaimedNodes;
+    } else if (ReclaimFrontierNodes && node->succ_empty() && !node->isSink())
+      // The only condition of shouldCollect() that can become true later is
+      // that the node has a successor. Most of the nodes created last, and,
+      // with a breadth-first work list, many more, are still on the frontier
+      // and would otherwise never be reclaimed.
+      FrontierNodes.push_back(node);
+  }
   ChangedNodes.clear();
 }
 
@@ -208,7 +208,8 @@ ExprEngine::ExprEngine(cross_tu::CrossTranslationUnitContext &CTU,
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
   if (TrimInterval != 0) {
     // Enable eager node reclaimation when constructing the ExplodedGraph.
-    G.enableNodeReclamation(TrimInterval);
+    G.enableNodeReclamation(TrimInterval,
+                            mgr.options.shouldTrimGraphAggressively());
   }
 }
 
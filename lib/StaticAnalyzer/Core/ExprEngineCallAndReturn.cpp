@@ -17,6 +17,7 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
 #include "clang/Analysis/ConstructionContext.h"
+#include "clang/StaticAnalyzer/Core/AnalysisProfiler.h"
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "llvm/ADT/SmallSet.h"
@@ -459,6 +460,8 @@ bool ExprEngine::inlineCall(const CallEvent &Call, const Decl *D,
 
   NumInlinedCalls++;
   Engine.FunctionSummaries->bumpNumTimesInlined(D);
+  if (AnalysisProfiler *Profiler = getCheckerManager().getProfiler())
+    Profiler->recordInlining(D, /*Inlined=*/true);
 
   // Mark the decl as visited.
   if (VisitedCallees)
@@ -933,6 +936,11 @@ static bool isTrivialObjectAssignment(const CallEvent &Call) {
   return MD->isTrivial();
 }
 
+void ExprEngine::recordNotInlined(const Decl *D) {
+  if (AnalysisProfiler *Profiler = getCheckerManager().getProfiler())
+    Profiler->recordInlining(D, /*Inlined=*/false);
+}
+
 void ExprEngine::defaultEvalCall(NodeBuilder &Bldr, ExplodedNode *Pred,
                                  const CallEvent &CallTemplate,
                                  const EvalCallOptions &CallOpts) {
@@ -970,6 +978,7 @@ void ExprEngine::defaultEvalCall(NodeBuilder &Bldr, ExplodedNode *Pred,
 
         // Don't inline if we're not in any dynamic dispatch mode.
         if (Options.getIPAMode() != IPAK_DynamicDispatch) {
+          recordNotInlined(D);
           conservativeEvalCall(*Call, Bldr, Pred, State);
           return;
         }
@@ -978,6 +987,8 @@ void ExprEngine::defaultEvalCall(NodeBuilder &Bldr, ExplodedNode *Pred,
       // We are not bifurcating and we do have a Decl, so just inline.
       if (inlineCall(*Call, D, Bldr, Pred, State))
         return;
+    } else if (D) {
+      recordNotInlined(D);
     }
   }
 
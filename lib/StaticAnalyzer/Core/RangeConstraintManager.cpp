@@ -17,16 +17,48 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace clang;
 using namespace ento;
 
-void RangeSet::IntersectInRange(BasicValueFactory &BV, Factory &F,
+RangeSet RangeSet::Factory::getSet(ArrayRef<Range> Ranges) {
+  if (Ranges.empty())
+    return getEmptySet();
+
+  llvm::FoldingSetNodeID ID;
+  Storage::Profile(ID, Ranges);
+  void *InsertPos;
+  if (Storage *Existing = Sets.FindNodeOrInsertPos(ID, InsertPos))
+    return RangeSet(Existing);
+
+  void *Mem = Arena.Allocate(Storage::totalSizeToAlloc<Range>(Ranges.size()),
+                             alignof(Storage));
+  Storage *New = new (Mem) Storage(Ranges);
+  Sets.InsertNode(New, InsertPos);
+  return RangeSet(New);
+}
+
+RangeSet RangeSet::addRange(Factory &F, const RangeSet &RS) const {
+  if (isEmpty())
+    return RS;
+  if (RS.isEmpty())
+    return *this;
+
+  SmallVector<Range, 4> Ranges;
+  std::merge(begin(), end(), RS.begin(), RS.end(), std::back_inserter(Ranges),
+             RangeTrait::isLess);
+  Ranges.erase(std::unique(Ranges.begin(), Ranges.end()), Ranges.end());
+  return F.getSet(Ranges);
+}
+
+void RangeSet::IntersectInRange(BasicValueFactory &BV,
                       const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                      PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                      PrimRangeSet::iterator &e) const {
+                      SmallVectorImpl<Range> &newRanges, iterator &i,
+                      iterator &e) const {
   // There are six cases for each range R in the set:
   //   1. R is entirely before the intersection range.
   //   2. R is entirely after the intersection range.
@@ -45,24 +77,23 @@ void RangeSet::IntersectInRange(BasicValueFactory &BV, Factory &F,
 
     if (i->Includes(Lower)) {
       if (i->Includes(Upper)) {
-        newRanges =
-            F.add(newRanges, Range(BV.getValue(Lower), BV.getValue(Upper)));
+        newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
         break;
       } else
-        newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+        newRanges.push_back(Range(BV.getValue(Lower), i->To()));
     } else {
       if (i->Includes(Upper)) {
-        newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+        newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
         break;
       } else
-        newRanges = F.add(newRanges, *i);
+        newRanges.push_back(*i);
     }
   }
 }
 
 const llvm::APSInt &RangeSet::getMinValue() const {
   assert(!isEmpty());
-  return ranges.begin()->From();
+  return begin()->From();
 }
 
 bool RangeSet::pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -158,20 +189,22 @@ RangeSet RangeSet::Intersect(BasicValueFactory &BV, Factory &F,
   if (!pin(Lower, Upper))
     return F.getEmptySet();
 
-  PrimRangeSet newRanges = F.getEmptySet();
+  // The ranges are produced in increasing order, so they can be handed to
+  // the factory as they are.
+  SmallVector<Range, 4> newRanges;
 
-  PrimRangeSet::iterator i = begin(), e = end();
+  iterator i = begin(), e = end();
   if (Lower <= Upper)
-    IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+    IntersectInRange(BV, Lower, Upper, newRanges, i, e);
   else {
     // The order of the next two statements is important!
     // IntersectInRange() does not reset the iteration state for i and e.
     // Therefore, the lower range most be handled first.
-    IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-    IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+    IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+    IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
   }
 
-  return newRanges;
+  return F.getSet(newRanges);
 }
 
 void RangeSet::print(raw_ostream &os) const {
@@ -26,9 +26,12 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/Support/TrailingObjects.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <utility>
 
 using namespace clang;
@@ -142,10 +145,265 @@ LLVM_DUMP_METHOD void BindingKey::dump() const { llvm::errs() << *this; }
 // Actual Store type.
 //===----------------------------------------------------------------------===//
 
-typedef llvm::ImmutableMap<BindingKey, SVal>    ClusterBindings;
-typedef llvm::ImmutableMapRef<BindingKey, SVal> ClusterBindingsRef;
 typedef std::pair<BindingKey, SVal> BindingPair;
 
+namespace {
+/// The bindings of a cluster, ordered by key.
+///
+/// Depending on its factory, a cluster keeps its bindings either in an AVL
+/// tree, of which an update copies one path, or in a uniqued flat array, which
+/// an update copies entirely but which is compact and cheap to look up and to
+/// iterate. At most one of the two is non-empty.
+class ClusterBindings {
+  typedef llvm::ImmutableMap<BindingKey, SVal> TreeTy;
+
+public:
+  class Factory;
+
+private:
+  /// The uniqued bindings of a non-empty flat cluster.
+  class Storage final : public llvm::FoldingSetNode,
+                        private llvm::TrailingObjects<Storage, BindingPair> {
+    friend TrailingObjects;
+    friend class ClusterBindings;
+    friend class Factory;
+
+    unsigned NumBindings;
+
+    explicit Storage(ArrayRef<BindingPair> Bindings)
+        : NumBindings(Bindings.size()) {
+      std::uninitialized_copy(Bindings.begin(), Bindings.end(),
+                              getTrailingObjects<BindingPair>());
+    }
+
+    size_t numTrailingObjects(OverloadToken<BindingPair>) const {
+      return NumBindings;
+    }
+
+  public:
+    ArrayRef<BindingPair> bindings() const {
+      return {getTrailingObjects<BindingPair>(), NumBindings};
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID,
+                        ArrayRef<BindingPair> Bindings) {
+      for (const BindingPair &P : Bindings) {
+        P.first.Profile(ID);
+        P.second.Profile(ID);
+      }
+    }
+
+    void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, bindings()); }
+  };
+
+  TreeTy Tree;
+  const Storage *Flat;
+
+  ClusterBindings(TreeTy Tree, const Storage *Flat) : Tree(Tree), Flat(Flat) {}
+
+  ArrayRef<BindingPair> flatBindings() const {
+    return Flat ? Flat->bindings() : ArrayRef<BindingPair>();
+  }
+
+public:
+  class iterator {
+    friend class ClusterBindings;
+
+    const BindingPair *FlatI, *FlatE;
+    TreeTy::iterator TreeI;
+
+    iterator(const BindingPair *FlatI, const BindingPair *FlatE,
+             TreeTy::iterator TreeI)
+        : FlatI(FlatI), FlatE(FlatE), TreeI(TreeI) {}
+
+  public:
+    const BindingPair &operator*() const {
+      return FlatI != FlatE ? *FlatI : *TreeI;
+    }
+    const BindingPair *operator->() const { return &**this; }
+
+    const BindingKey &getKey() const { return (**this).first; }
+    const SVal &getData() const { return (**this).second; }
+
+    iterator &operator++() {
+      if (FlatI != FlatE)
+        ++FlatI;
+      else
+        ++TreeI;
+      return *this;
+    }
+
+    bool operator==(const iterator &X) const {
+      return FlatI == X.FlatI && TreeI == X.TreeI;
+    }
+    bool operator!=(const iterator &X) const { return !(*this == X); }
+  };
+
+  iterator begin() const {
+    ArrayRef<BindingPair> Bindings = flatBindings();
+    return iterator(Bindings.begin(), Bindings.end(), Tree.begin());
+  }
+
+  iterator end() const {
+    ArrayRef<BindingPair> Bindings = flatBindings();
+    return iterator(Bindings.end(), Bindings.end(), Tree.end());
+  }
+
+  bool isEmpty() const { return !Flat && Tree.isEmpty(); }
+
+  const SVal *lookup(BindingKey K) const {
+    if (!Flat)
+      return Tree.lookup(K);
+
+    ArrayRef<BindingPair> Bindings = Flat->bindings();
+    const BindingPair *I = std::lower_bound(
+        Bindings.begin(), Bindings.end(), K,
+        [](const BindingPair &P, BindingKey K) { return P.first < K; });
+    if (I == Bindings.end() || !(I->first == K))
+      return nullptr;
+    return &I->second;
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    ID.AddPointer(Flat);
+    Tree.Profile(ID);
+  }
+
+  bool operator==(const ClusterBindings &X) const {
+    return Flat == X.Flat && Tree == X.Tree;
+  }
+  bool operator!=(const ClusterBindings &X) const { return !(*this == X); }
+};
+
+class ClusterBindings::Factory {
+  TreeTy::Factory TreeFactory;
+  llvm::BumpPtrAllocator &Arena;
+  llvm::FoldingSet<Storage> FlatClusters;
+  bool UseFlatBindings = false;
+
+public:
+  explicit Factory(llvm::BumpPtrAllocator &Alloc)
+      : TreeFactory(Alloc), Arena(Alloc) {}
+
+  /// Keep the bindings of the clusters in flat arrays rather than in trees.
+  /// Must be set before any cluster is created.
+  void setUseFlatBindings(bool Flat) { UseFlatBindings = Flat; }
+
+  ClusterBindings getEmptyMap() {
+    return ClusterBindings(TreeFactory.getEmptyMap(), nullptr);
+  }
+
+  ClusterBindings add(ClusterBindings C, BindingKey K, SVal V) {
+    return add(C, BindingPair(K, V));
+  }
+
+  /// Add all of \p Bindings to the cluster, later bindings of the same key
+  /// replacing earlier ones, with a single update of a flat cluster.
+  ClusterBindings add(ClusterBindings C, ArrayRef<BindingPair> Bindings);
+
+  ClusterBindings remove(ClusterBindings C, BindingKey K) {
+    return remove(C, llvm::makeArrayRef(K));
+  }
+
+  /// Remove the bindings of all of \p Keys from the cluster, with a single
+  /// update of a flat cluster. The keys need not be bound.
+  ClusterBindings remove(ClusterBindings C, ArrayRef<BindingKey> Keys);
+
+private:
+  /// Return the flat cluster of \p Bindings, which must be sorted by key
+  /// and must not have duplicate keys.
+  ClusterBindings getFlatCluster(ArrayRef<BindingPair> Bindings);
+};
+} // end anonymous namespace
+
+static bool compareBindingKeys(const BindingPair &LHS, const BindingPair &RHS) {
+  return LHS.first < RHS.first;
+}
+
+ClusterBindings ClusterBindings::Factory::add(ClusterBindings C,
+                                              ArrayRef<BindingPair> Bindings) {
+  if (!UseFlatBindings) {
+    assert(!C.Flat && "Flat cluster in a tree factory");
+    TreeTy Tree = C.Tree;
+    for (const BindingPair &P : Bindings)
+      Tree = TreeFactory.add(Tree, P.first, P.second);
+    return ClusterBindings(Tree, nullptr);
+  }
+  assert(C.Tree.isEmpty() && "Tree cluster in a flat factory");
+
+  // Order the new bindings by key, keeping only the last binding of each key.
+  SmallVector<BindingPair, 16> Added(Bindings.begin(), Bindings.end());
+  std::stable_sort(Added.begin(), Added.end(), compareBindingKeys);
+  auto Last = Added.begin();
+  for (auto I = Added.begin(), E = Added.end(); I != E; ++I) {
+    if (Last != I && !(Last->first == I->first))
+      ++Last;
+    *Last = *I;
+  }
+  if (!Added.empty())
+    Added.erase(std::next(Last), Added.end());
+
+  // Merge them with the existing bindings, which they replace.
+  ArrayRef<BindingPair> Existing = C.flatBindings();
+  SmallVector<BindingPair, 32> Merged;
+  Merged.reserve(Existing.size() + Added.size());
+  auto EI = Existing.begin(), EE = Existing.end();
+  for (const BindingPair &P : Added) {
+    for (; EI != EE && EI->first < P.first; ++EI)
+      Merged.push_back(*EI);
+    if (EI != EE && EI->first == P.first)
+      ++EI;
+    Merged.push_back(P);
+  }
+  Merged.append(EI, EE);
+
+  return getFlatCluster(Merged);
+}
+
+ClusterBindings ClusterBindings::Factory::remove(ClusterBindings C,
+                                                 ArrayRef<BindingKey> Keys) {
+  if (!UseFlatBindings) {
+    assert(!C.Flat && "Flat cluster in a tree factory");
+    TreeTy Tree = C.Tree;
+    for (BindingKey K : Keys)
+      Tree = TreeFactory.remove(Tree, K);
+    return ClusterBindings(Tree, nullptr);
+  }
+  assert(C.Tree.isEmpty() && "Tree cluster in a flat factory");
+
+  SmallVector<BindingKey, 16> Removed(Keys.begin(), Keys.end());
+  std::sort(Removed.begin(), Removed.end());
+
+  ArrayRef<BindingPair> Existing = C.flatBindings();
+  SmallVector<BindingPair, 32> Kept;
+  for (const BindingPair &P : Existing)
+    if (!std::binary_search(Removed.begin(), Removed.end(), P.first))
+      Kept.push_back(P);
+
+  if (Kept.size() == Existing.size())
+    return C;
+  return getFlatCluster(Kept);
+}
+
+ClusterBindings
+ClusterBindings::Factory::getFlatCluster(ArrayRef<BindingPair> Bindings) {
+  if (Bindings.empty())
+    return getEmptyMap();
+
+  llvm::FoldingSetNodeID ID;
+  Storage::Profile(ID, Bindings);
+  void *InsertPos;
+  if (Storage *Existing = FlatClusters.FindNodeOrInsertPos(ID, InsertPos))
+    return ClusterBindings(TreeFactory.getEmptyMap(), Existing);
+
+  void *Mem =
+      Arena.Allocate(Storage::totalSizeToAlloc<BindingPair>(Bindings.size()),
+                     alignof(Storage));
+  Storage *New = new (Mem) Storage(Bindings);
+  FlatClusters.InsertNode(New, InsertPos);
+  return ClusterBindings(TreeFactory.getEmptyMap(), New);
+}
+
 typedef llvm::ImmutableMap<const MemRegion *, ClusterBindings>
         RegionBindings;
 
@@ -197,6 +455,14 @@ public:
            removeBinding(R, BindingKey::Default);
   }
 
+  /// Add \p Bindings, which must all belong to the same cluster, with a
+  /// single update of the cluster.
+  RegionBindingsRef addBindings(ArrayRef<BindingPair> Bindings) const;
+
+  /// Remove the bindings of \p Keys, which must all belong to the same
+  /// cluster, with a single update of the cluster.
+  RegionBindingsRef removeBindings(ArrayRef<BindingKey> Keys) const;
+
   Optional<SVal> getDirectBinding(const MemRegion *R) const;
 
   /// getDefaultBinding - Returns an SVal* representing an optional default
@@ -280,6 +546,47 @@ RegionBindingsRef RegionBindingsRef::removeBinding(const MemRegion *R,
   return removeBinding(BindingKey::Make(R, k));
 }
 
+RegionBindingsRef
+RegionBindingsRef::addBindings(ArrayRef<BindingPair> Bindings) const {
+  if (Bindings.empty())
+    return *this;
+
+  const MemRegion *Base = Bindings.front().first.getBaseRegion();
+  assert(llvm::all_of(Bindings,
+                      [Base](const BindingPair &P) {
+                        return P.first.getBaseRegion() == Base;
+                      }) &&
+         "Bindings of different clusters");
+
+  const ClusterBindings *ExistingCluster = lookup(Base);
+  ClusterBindings Cluster =
+      (ExistingCluster ? *ExistingCluster : CBFactory->getEmptyMap());
+
+  return add(Base, CBFactory->add(Cluster, Bindings));
+}
+
+RegionBindingsRef
+RegionBindingsRef::removeBindings(ArrayRef<BindingKey> Keys) const {
+  if (Keys.empty())
+    return *this;
+
+  const MemRegion *Base = Keys.front().getBaseRegion();
+  assert(llvm::all_of(Keys,
+                      [Base](BindingKey K) {
+                        return K.getBaseRegion() == Base;
+                      }) &&
+         "Bindings of different clusters");
+
+  const ClusterBindings *Cluster = lookup(Base);
+  if (!Cluster)
+    return *this;
+
+  ClusterBindings NewCluster = CBFactory->remove(*Cluster, Keys);
+  if (NewCluster.isEmpty())
+    return remove(Base);
+  return add(Base, NewCluster);
+}
+
 //===----------------------------------------------------------------------===//
 // Fine-grained control of RegionStoreManager.
 //===----------------------------------------------------------------------===//
@@ -348,6 +655,8 @@ public:
       AnalyzerOptions &Options = Eng->getAnalysisManager().options;
       SmallStructLimit =
         Options.getOptionAsInteger("region-store-small-struct-limit", 2);
+      CBFactory.setUseFlatBindings(
+          Options.getBooleanOption("region-store-flat-clusters", false));
     }
   }
 
@@ -923,11 +1232,10 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   collectSubRegionBindings(Bindings, svalBuilder, *Cluster, Top, TopKey,
                            /*IncludeAllDefaultBindings=*/false);
 
-  ClusterBindingsRef Result(*Cluster, CBFactory);
-  for (SmallVectorImpl<BindingPair>::const_iterator I = Bindings.begin(),
-                                                    E = Bindings.end();
-       I != E; ++I)
-    Result = Result.remove(I->first);
+  SmallVector<BindingKey, 32> Keys;
+  for (const BindingPair &P : Bindings)
+    Keys.push_back(P.first);
+  RegionBindingsRef Result = B.removeBindings(Keys);
 
   // If we're invalidating a region with a symbolic offset, we need to make sure
   // we don't treat the base region as uninitialized anymore.
@@ -935,13 +1243,10 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   // collectSubRegionBindings.
   if (TopKey.hasSymbolicOffset()) {
     const SubRegion *Concrete = TopKey.getConcreteOffsetRegion();
-    Result = Result.add(BindingKey::Make(Concrete, BindingKey::Default),
-                        UnknownVal());
+    Result = Result.addBinding(Concrete, BindingKey::Default, UnknownVal());
   }
 
-  if (Result.isEmpty())
-    return B.remove(ClusterHead);
-  return B.add(ClusterHead, Result.asImmutableMap());
+  return Result;
 }
 
 namespace {
@@ -1143,6 +1448,9 @@ void invalidateRegionsWorker::VisitCluster(const MemRegion *baseR,
       if (!C)
         goto conjure_default;
 
+      // Remove the bindings within the array boundaries in one go.
+      SmallVector<BindingKey, 32> Removed;
+      SmallVector<SVal, 8> RemovedSymbolicRegions;
       for (ClusterBindings::iterator I = C->begin(), E = C->end(); I != E;
            ++I) {
         const BindingKey &BK = I.getKey();
@@ -1156,15 +1464,19 @@ void invalidateRegionsWorker::VisitCluster(const MemRegion *baseR,
              (UpperOverflow &&
               (*ROffset >= LowerOffset || *ROffset < UpperOffset)) ||
              (LowerOffset == UpperOffset && *ROffset == LowerOffset))) {
-          B = B.removeBinding(I.getKey());
+          Removed.push_back(I.getKey());
           // Bound symbolic regions need to be invalidated for dead symbol
           // detection.
           SVal V = I.getData();
           const MemRegion *R = V.getAsRegion();
           if (R && isa<SymbolicRegion>(R))
-            VisitBinding(V);
+            RemovedSymbolicRegions.push_back(V);
         }
       }
+
+      B = B.removeBindings(Removed);
+      for (SVal V : RemovedSymbolicRegions)
+        VisitBinding(V);
     }
   conjure_default:
       // Set the default value of the array to conjured symbol.
@@ -2175,6 +2487,19 @@ RegionStoreManager::bindArray(RegionBindingsConstRef B,
 
   RegionBindingsRef NewB(B);
 
+  // Scalar elements at concrete offsets are bound with a single update of the
+  // cluster instead of one update per element. The elements do not overlap,
+  // so the bindings each of them replaces can be collected up front.
+  bool BindInBulk = !ElementTy->isStructureOrClassType() &&
+                    !ElementTy->isArrayType() && !ElementTy->isVectorType() &&
+                    !ElementTy->isUnionType() &&
+                    !BindingKey::Make(R, BindingKey::Default)
+                         .hasSymbolicOffset();
+  const ClusterBindings *Cluster =
+      BindInBulk ? B.lookup(R->getBaseRegion()) : nullptr;
+  SmallVector<BindingPair, 32> Replaced;
+  SmallVector<BindingPair, 32> Added;
+
   for (; Size.hasValue() ? i < Size.getValue() : true ; ++i, ++VI) {
     // The init list might be shorter than the array length.
     if (VI == VE)
@@ -2183,7 +2508,14 @@ RegionStoreManager::bindArray(RegionBindingsConstRef B,
     const NonLoc &Idx = svalBuilder.makeArrayIndex(i);
     const ElementRegion *ER = MRMgr.getElementRegion(ElementTy, Idx, R, Ctx);
 
-    if (ElementTy->isStructureOrClassType())
+    if (BindInBulk) {
+      BindingKey K = BindingKey::Make(ER, BindingKey::Direct);
+      assert(!K.hasSymbolicOffset() && "Element of a concrete array");
+      if (Cluster)
+        collectSubRegionBindings(Replaced, svalBuilder, *Cluster, ER,
+                                 /*IncludeAllDefaultBindings=*/false);
+      Added.push_back(BindingPair(K, *VI));
+    } else if (ElementTy->isStructureOrClassType())
       NewB = bindStruct(NewB, ER, *VI);
     else if (ElementTy->isArrayType())
       NewB = bindArray(NewB, ER, *VI);
@@ -2191,6 +2523,13 @@ RegionStoreManager::bindArray(RegionBindingsConstRef B,
       NewB = bind(NewB, loc::MemRegionVal(ER), *VI);
   }
 
+  if (BindInBulk) {
+    SmallVector<BindingKey, 32> ReplacedKeys;
+    for (const BindingPair &P : Replaced)
+      ReplacedKeys.push_back(P.first);
+    NewB = NewB.removeBindings(ReplacedKeys).addBindings(Added);
+  }
+
   // If the init list is shorter than the array length (or the array has
   // variable length), set the array default value. Values that are already set
   // are not overwritten.
@@ -17,7 +17,9 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
+#include <algorithm>
 #include <deque>
+#include <iterator>
 #include <vector>
 
 using namespace clang;
@@ -27,6 +29,8 @@ using namespace ento;
 
 STATISTIC(MaxQueueSize, "Maximum size of the worklist");
 STATISTIC(MaxReachableSize, "Maximum size of auxiliary worklist set");
+STATISTIC(NumStolenUnits,
+          "The # of worklist units taken from another depth-first search");
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -252,3 +256,70 @@ public:
 std::unique_ptr<WorkList> WorkList::makeUnexploredFirstPriorityQueue() {
   return llvm::make_unique<UnexploredFirstPriorityQueue>();
 }
+
+namespace {
+
+/// Interleaves several depth-first searches of the graph. The searches take
+/// turns after a fixed number of steps. A search that runs out of nodes takes
+/// the oldest node of the search with the most nodes left, which is the root
+/// of the largest subtree nobody explored yet. Thus when the node budget runs
+/// out on a large function, several distant parts of it have been explored,
+/// instead of only the first subtree that plain DFS entered.
+class InterleavedDFS : public WorkList {
+  static constexpr unsigned NumWorkers = 4;
+  static constexpr unsigned StepsPerTurn = 128;
+
+  /// The nodes of each search. Searches take nodes from the back of their own
+  /// deque, and from the front of the others.
+  std::deque<WorkListUnit> Workers[NumWorkers];
+
+  unsigned CurrentWorker = 0;
+  unsigned StepsLeft = StepsPerTurn;
+  unsigned NumUnits = 0;
+
+public:
+  bool hasWork() const override {
+    return NumUnits != 0;
+  }
+
+  void enqueue(const WorkListUnit &U) override {
+    // The successors of a node belong to the search that explored it.
+    Workers[CurrentWorker].push_back(U);
+    ++NumUnits;
+    MaxQueueSize.updateMax(NumUnits);
+  }
+
+  WorkListUnit dequeue() override {
+    assert(NumUnits != 0);
+    if (StepsLeft == 0) {
+      CurrentWorker = (CurrentWorker + 1) % NumWorkers;
+      StepsLeft = StepsPerTurn;
+    }
+    --StepsLeft;
+    --NumUnits;
+
+    std::deque<WorkListUnit> &Own = Workers[CurrentWorker];
+    if (!Own.empty()) {
+      WorkListUnit U = Own.back();
+      Own.pop_back();
+      return U;
+    }
+
+    std::deque<WorkListUnit> &Victim = *std::max_element(
+        std::begin(Workers), std::end(Workers),
+        [](const std::deque<WorkListUnit> &LHS,
+           const std::deque<WorkListUnit> &RHS) {
+          return LHS.size() < RHS.size();
+        });
+    ++NumStolenUnits;
+    WorkListUnit U = Victim.front();
+    Victim.pop_front();
+    return U;
+  }
+};
+
+} // namespace
+
+std::unique_ptr<WorkList> WorkList::makeInterleavedDFS() {
+  return llvm::make_unique<InterleavedDFS>();
+}
@@ -19,8 +19,24 @@ using namespace ento;
 
 #if CLANG_ANALYZER_WITH_Z3
 
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+
 #include <z3.h>
 
+#define DEBUG_TYPE "Z3ConstraintManager"
+
+STATISTIC(NumZ3Queries, "The # of satisfiability queries checked with Z3");
+STATISTIC(NumZ3QueryCacheHits,
+          "The # of satisfiability queries answered from the query cache");
+
+/// The maximum number of nested solver scopes holding state constraints.
+static const unsigned MaxSolverScopes = 64;
+
+/// The maximum number of satisfiability results kept in the query cache.
+static const unsigned MaxCachedQueries = 16384;
+
 // Forward declarations
 namespace {
 class Z3Expr;
@@ -63,18 +79,26 @@ public:
   ~Z3Config() { Z3_del_config(Config); }
 }; // end class Z3Config
 
+/// The Z3 context is shared by all the live constraint managers, so that the
+/// refutation manager of the bug reporter can coexist with the constraint
+/// manager of the analysis, and is deleted with the last of them.
 class Z3Context {
-  Z3_context ZC_P;
+  static unsigned NumUsers;
 
 public:
   static Z3_context ZC;
 
-  Z3Context() : ZC_P(Z3_mk_context_rc(Z3Config().Config)) { ZC = ZC_P; }
+  Z3Context() {
+    if (NumUsers++ == 0)
+      ZC = Z3_mk_context_rc(Z3Config().Config);
+  }
 
   ~Z3Context() {
+    if (--NumUsers != 0)
+      return;
     Z3_del_context(ZC);
     Z3_finalize_memory();
-    ZC_P = nullptr;
+    ZC = nullptr;
   }
 }; // end class Z3Context
 
@@ -187,6 +211,8 @@ public:
 class Z3Expr {
   friend class Z3Model;
   friend class Z3Solver;
+  friend class Z3ConstraintManager;
+  friend class Z3Query;
 
   Z3_ast AST;
 
@@ -841,25 +867,6 @@ public:
     Z3_solver_assert(Z3Context::ZC, Solver, Exp.AST);
   }
 
-  /// Given a program state, construct the logical conjunction and add it to
-  /// the solver
-  void addStateConstraints(ProgramStateRef State) {
-    // TODO: Don't add all the constraints, only the relevant ones
-    ConstraintZ3Ty CZ = State->get<ConstraintZ3>();
-    ConstraintZ3Ty::iterator I = CZ.begin(), IE = CZ.end();
-
-    // Construct the logical AND of all the constraints
-    if (I != IE) {
-      std::vector<Z3_ast> ASTs;
-
-      while (I != IE)
-        ASTs.push_back(I++->second.AST);
-
-      Z3Expr Conj = Z3Expr::fromNBinOp(BO_LAnd, ASTs);
-      addConstraint(Conj);
-    }
-  }
-
   /// Check if the constraints are satisfiable
   Z3_lbool check() { return Z3_solver_check(Z3Context::ZC, Solver); }
 
@@ -893,10 +900,56 @@ void Z3ErrorHandler(Z3_context Context, Z3_error_code Error) {
                            llvm::Twine(Z3_get_error_msg_ex(Context, Error)));
 }
 
+/// A satisfiability query, as the set of the asserted expressions. Z3
+/// hash-conses its ASTs, so the expressions are canonicalized by sorting and
+/// uniquing them by identity.
+class Z3Query {
+  std::vector<Z3Expr> Exprs;
+
+public:
+  void add(const Z3Expr &Exp) { Exprs.push_back(Exp); }
+
+  void canonicalize() {
+    std::sort(Exprs.begin(), Exprs.end(), isLess);
+    Exprs.erase(std::unique(Exprs.begin(), Exprs.end(), isSame), Exprs.end());
+  }
+
+  bool operator<(const Z3Query &Other) const {
+    return std::lexicographical_compare(Exprs.begin(), Exprs.end(),
+                                        Other.Exprs.begin(),
+                                        Other.Exprs.end(), isLess);
+  }
+
+private:
+  static bool isLess(const Z3Expr &LHS, const Z3Expr &RHS) {
+    return LHS.AST < RHS.AST;
+  }
+
+  static bool isSame(const Z3Expr &LHS, const Z3Expr &RHS) {
+    return LHS.AST == RHS.AST;
+  }
+}; // end class Z3Query
+
 class Z3ConstraintManager : public SMTConstraintManager {
   Z3Context Context;
   mutable Z3Solver Solver;
 
+  /// The state constraints asserted on the solver, in assertion order. Each
+  /// solver scope asserts the constraints from its entry in ScopeBegin up to
+  /// the entry of the next scope, so the constraints shared by the states of
+  /// a path are only asserted once. The sets of ASTs are keyed on untyped
+  /// pointers, since Z3_ast points to an incomplete type.
+  mutable std::vector<Z3Expr> Asserted;
+  mutable llvm::DenseSet<const void *> AssertedASTs;
+  mutable llvm::SmallVector<unsigned, 16> ScopeBegin;
+
+  /// The constraints added for refutation, which are asserted directly on the
+  /// solver.
+  Z3Query RefutationQuery;
+
+  /// The results of the previous satisfiability queries.
+  mutable std::map<Z3Query, Z3_lbool> QueryCache;
+
 public:
   Z3ConstraintManager(SubEngine *SE, SValBuilder &SB)
       : SMTConstraintManager(SE, SB),
@@ -911,6 +964,8 @@ public:
 
   ConditionTruthVal isModelFeasible() override;
 
+  void resetConstraints() override;
+
   //===------------------------------------------------------------------===//
   // Implementation for interface from ConstraintManager.
   //===------------------------------------------------------------------===//
@@ -955,6 +1010,19 @@ private:
   // Generate and check a Z3 model, using the given constraint.
   Z3_lbool checkZ3Model(ProgramStateRef State, const Z3Expr &Exp) const;
 
+  // Assert the constraints of the given state on the solver, reusing the
+  // solver scopes whose constraints are all part of the state.
+  void assertStateConstraints(ProgramStateRef State) const;
+
+  // Pop the given number of solver scopes and their constraints.
+  void popScopes(unsigned NumScopes) const;
+
+  // Look up the result of a query in the query cache.
+  Optional<Z3_lbool> lookupQuery(const Z3Query &Query) const;
+
+  // Record the result of a query in the query cache.
+  void cacheQuery(Z3Query Query, Z3_lbool Result) const;
+
   // Generate a Z3Expr that represents the given symbolic expression.
   // Sets the hasComparison parameter if the expression has a comparison
   // operator.
@@ -1031,6 +1099,7 @@ private:
 }; // end class Z3ConstraintManager
 
 Z3_context Z3Context::ZC;
+unsigned Z3Context::NumUsers = 0;
 
 } // end anonymous namespace
 
@@ -1141,16 +1210,8 @@ ConditionTruthVal Z3ConstraintManager::checkNull(ProgramStateRef State,
   // Negate the constraint
   Z3Expr NotExp = getZ3ZeroExpr(VarExp, RetTy, false);
 
-  Solver.reset();
-  Solver.addStateConstraints(State);
-
-  Solver.push();
-  Solver.addConstraint(Exp);
-  Z3_lbool isSat = Solver.check();
-
-  Solver.pop();
-  Solver.addConstraint(NotExp);
-  Z3_lbool isNotSat = Solver.check();
+  Z3_lbool isSat = checkZ3Model(State, Exp);
+  Z3_lbool isNotSat = checkZ3Model(State, NotExp);
 
   // Zero is the only possible solution
   if (isSat == Z3_L_TRUE && isNotSat == Z3_L_FALSE)
@@ -1176,8 +1237,7 @@ const llvm::APSInt *Z3ConstraintManager::getSymVal(ProgramStateRef State,
 
     Z3Expr Exp = getZ3DataExpr(SD->getSymbolID(), Ty);
 
-    Solver.reset();
-    Solver.addStateConstraints(State);
+    assertStateConstraints(State);
 
     // Constraints are unsatisfiable
     if (Solver.check() != Z3_L_TRUE)
@@ -1195,8 +1255,11 @@ const llvm::APSInt *Z3ConstraintManager::getSymVal(ProgramStateRef State,
                             : Z3Expr::fromAPSInt(Value),
         false);
 
+    Solver.push();
     Solver.addConstraint(NotExp);
-    if (Solver.check() == Z3_L_TRUE)
+    Z3_lbool isNotSat = Solver.check();
+    Solver.pop();
+    if (isNotSat == Z3_L_TRUE)
       return nullptr;
 
     // This is the only solution, store it
@@ -1289,16 +1352,31 @@ void Z3ConstraintManager::addRangeConstraints(ConstraintRangeTy CR) {
           Z3Expr::fromBinOp(Constraints, BO_LOr, SymRange, IsSignedTy);
     }
     Solver.addConstraint(Constraints);
+    RefutationQuery.add(Constraints);
   }
 }
 
 clang::ento::ConditionTruthVal Z3ConstraintManager::isModelFeasible() {
-  if (Solver.check() == Z3_L_FALSE)
+  RefutationQuery.canonicalize();
+
+  Optional<Z3_lbool> Result = lookupQuery(RefutationQuery);
+  if (!Result) {
+    Result = Solver.check();
+    cacheQuery(RefutationQuery, *Result);
+  }
+
+  if (*Result == Z3_L_FALSE)
     return false;
 
   return ConditionTruthVal();
 }
 
+void Z3ConstraintManager::resetConstraints() {
+  popScopes(ScopeBegin.size());
+  Solver.reset();
+  RefutationQuery = Z3Query();
+}
+
 //===------------------------------------------------------------------===//
 // Internal implementation.
 //===------------------------------------------------------------------===//
@@ -1315,10 +1393,96 @@ ProgramStateRef Z3ConstraintManager::assumeZ3Expr(ProgramStateRef State,
 
 Z3_lbool Z3ConstraintManager::checkZ3Model(ProgramStateRef State,
                                            const Z3Expr &Exp) const {
-  Solver.reset();
+  Z3Query Query;
+  for (const auto &I : State->get<ConstraintZ3>())
+    Query.add(I.second);
+  Query.add(Exp);
+  Query.canonicalize();
+
+  if (Optional<Z3_lbool> Result = lookupQuery(Query))
+    return *Result;
+
+  assertStateConstraints(State);
+
+  Solver.push();
   Solver.addConstraint(Exp);
-  Solver.addStateConstraints(State);
-  return Solver.check();
+  Z3_lbool Result = Solver.check();
+  Solver.pop();
+
+  cacheQuery(std::move(Query), Result);
+  return Result;
+}
+
+void Z3ConstraintManager::assertStateConstraints(ProgramStateRef State) const {
+  ConstraintZ3Ty CZ = State->get<ConstraintZ3>();
+  llvm::SmallPtrSet<const void *, 32> StateASTs;
+  for (const auto &I : CZ)
+    StateASTs.insert(I.second.AST);
+
+  // Keep the outermost scopes whose constraints are all part of the state,
+  // and pop the first scope asserting a constraint of another path or of a
+  // dead symbol, along with the scopes above it.
+  unsigned NumKept = 0;
+  for (unsigned E = ScopeBegin.size(); NumKept != E; ++NumKept) {
+    unsigned Begin = ScopeBegin[NumKept];
+    unsigned End = NumKept + 1 != E ? ScopeBegin[NumKept + 1] : Asserted.size();
+    if (!std::all_of(Asserted.begin() + Begin, Asserted.begin() + End,
+                     [&](const Z3Expr &Exp) {
+                       return StateASTs.count(Exp.AST);
+                     }))
+      break;
+  }
+  popScopes(ScopeBegin.size() - NumKept);
+
+  // The asserted constraints are a subset of the state constraints.
+  if (AssertedASTs.size() == StateASTs.size())
+    return;
+
+  // Start over instead of nesting the scopes indefinitely.
+  if (ScopeBegin.size() == MaxSolverScopes)
+    popScopes(ScopeBegin.size());
+
+  Solver.push();
+  ScopeBegin.push_back(Asserted.size());
+  for (const auto &I : CZ) {
+    if (!AssertedASTs.insert(I.second.AST).second)
+      continue;
+    Asserted.push_back(I.second);
+    Solver.addConstraint(I.second);
+  }
+}
+
+void Z3ConstraintManager::popScopes(unsigned NumScopes) const {
+  if (NumScopes == 0)
+    return;
+
+  Solver.pop(NumScopes);
+  unsigned Begin = ScopeBegin[ScopeBegin.size() - NumScopes];
+  for (unsigned I = Begin, E = Asserted.size(); I != E; ++I)
+    AssertedASTs.erase(Asserted[I].AST);
+  Asserted.erase(Asserted.begin() + Begin, Asserted.end());
+  ScopeBegin.resize(ScopeBegin.size() - NumScopes);
+}
+
+Optional<Z3_lbool>
+Z3ConstraintManager::lookupQuery(const Z3Query &Query) const {
+  ++NumZ3Queries;
+  auto I = QueryCache.find(Query);
+  if (I == QueryCache.end())
+    return None;
+
+  ++NumZ3QueryCacheHits;
+  return I->second;
+}
+
+void Z3ConstraintManager::cacheQuery(Z3Query Query, Z3_lbool Result) const {
+  // Do not remember the queries that timed out.
+  if (Result == Z3_L_UNDEF)
+    return;
+
+  if (QueryCache.size() == MaxCachedQueries)
+    QueryCache.clear();
+  QueryCache.emplace(std::move(Query), Result);
 }
 
 Z3Expr Z3ConstraintManager::getZ3Expr(SymbolRef Sym, QualType *RetTy,
@@ -16,6 +16,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
+#include "clang/AST/ODRHash.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
 #include "clang/Analysis/CFG.h"
@@ -24,8 +25,10 @@
 #include "clang/Basic/SourceManager.h"
 #include "clang/CrossTU/CrossTranslationUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/USRGeneration.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
+#include "clang/StaticAnalyzer/Core/AnalysisProfiler.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
@@ -34,9 +37,15 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
@@ -62,6 +71,9 @@ STATISTIC(NumVisitedBlocksInAnalyzedFunctions,
           "The # of visited basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsUnchanged,
+          "The # of functions not analyzed because they are unchanged since "
+          "an earlier analysis found no bugs in them.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -193,10 +205,26 @@ public:
   std::unique_ptr<llvm::TimerGroup> AnalyzerTimers;
   std::unique_ptr<llvm::Timer> TUTotalTimer;
 
+  /// Records the cost of each checker and function, if requested.
+  std::unique_ptr<AnalysisProfiler> Profiler;
+
   /// The information about analyzed functions shared throughout the
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// Hash of the options that affect the analysis results, which is part of
+  /// every key of the incremental analysis cache.
+  std::string OptionsHash;
+
+  /// The hashes of the functions of the call graph that are part of the keys
+  /// of the incremental analysis cache, computed at most once per function.
+  /// Empty for the functions that can't be hashed.
+  llvm::DenseMap<const Decl *, std::string> FunctionHashes;
+
+  /// Whether the path-sensitive analysis of the current top level function
+  /// emitted any reports.
+  bool EmittedPathReports = false;
+
   AnalysisConsumer(CompilerInstance &CI, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
@@ -204,6 +232,12 @@ public:
         PP(CI.getPreprocessor()), OutDir(outdir), Opts(std::move(opts)),
         Plugins(plugins), Injector(injector), CTU(CI) {
     DigestAnalyzerOptions();
+    OptionsHash = computeOptionsHash(CI);
+    if (Opts->naiveCTUEnabled()) {
+      CTU.setLoadedASTMemoryLimit(uint64_t(Opts->getCTUMaxLoadedASTMemory())
+                                  << 20);
+      CTU.setLazyDefinitionLookup(Opts->shouldLookupCTUDefinitionsLazily());
+    }
     if (Opts->PrintStats || Opts->shouldSerializeStats()) {
       AnalyzerTimers = llvm::make_unique<llvm::TimerGroup>(
           "analyzer", "Analyzer timers");
@@ -296,6 +330,12 @@ public:
     checkerMgr = createCheckerManager(*Opts, PP.getLangOpts(), Plugins,
                                       PP.getDiagnostics());
 
+    if (!Opts->getAnalysisProfileOutput().empty() ||
+        Opts->shouldProfileAnalysis()) {
+      Profiler = llvm::make_unique<AnalysisProfiler>();
+      checkerMgr->setProfiler(Profiler.get());
+    }
+
     Mgr = llvm::make_unique<AnalysisManager>(
         *Ctx, PP.getDiagnostics(), PP.getLangOpts(), PathConsumers,
         CreateStoreMgr, CreateConstraintMgr, checkerMgr.get(), *Opts, Injector);
@@ -318,6 +358,22 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// Hash the options that affect the analysis results, before any option
+  /// is queried and added to the config table with its default value.
+  std::string computeOptionsHash(CompilerInstance &CI);
+
+  /// Compute the key of the root \p N in the incremental analysis cache from
+  /// the bodies of all the functions it may call, which are collected in
+  /// \p Dependencies, the definitions they refer to, and their function
+  /// summaries as left by the roots analyzed before. Returns false if \p N
+  /// can't be cached.
+  bool getIncrementalCacheKey(CallGraphNode *N, SmallVectorImpl<char> &Key,
+                              SetOfConstDecls &Dependencies);
+
+  /// Returns the hash of the function \p D for the keys of the incremental
+  /// analysis cache, or an empty string if \p D can't be hashed.
+  std::string getFunctionHash(const Decl *D);
+
   /// Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -393,6 +449,9 @@ private:
   AnalysisMode getModeForDecl(Decl *D, AnalysisMode Mode);
   void runAnalysisOnTranslationUnit(ASTContext &C);
 
+  /// Print the costs recorded by the profiler, as requested by the options.
+  void reportAnalysisProfile();
+
   /// Print \p S to stderr if \c Opts->AnalyzerDisplayProgress is set.
   void reportAnalyzerProgress(StringRef S);
 };
@@ -450,6 +509,455 @@ static bool shouldSkipFunction(const Decl *D,
   return Visited.count(D);
 }
 
+/// Returns the functions of the call graph that shard \p ShardIndex of
+/// \p ShardCount analyzes as top level functions.
+///
+/// The call graph is split into its weakly connected components, which are
+/// handed out whole, largest first, to the shard with the fewest functions so
+/// far. A function is only inlined into callers of its own component, so the
+/// functions a shard analyzes, and the ones it skips because they were
+/// inlined, are the same as in a single analyzer run over the whole
+/// translation unit. (Callees only reached through dynamic dispatch, which
+/// the call graph does not see, may be analyzed once more as top level
+/// functions.) Every shard computes the same assignment.
+static llvm::SmallPtrSet<const Decl *, 32>
+getDeclsInShard(ArrayRef<CallGraphNode *> Order, unsigned ShardCount,
+                unsigned ShardIndex) {
+  llvm::EquivalenceClasses<const CallGraphNode *> Components;
+  for (const CallGraphNode *N : Order) {
+    if (!N->getDecl())
+      continue;
+    Components.insert(N);
+    for (const CallGraphNode *Callee : *N)
+      if (Callee->getDecl())
+        Components.unionSets(N, Callee);
+  }
+
+  // Number the components in the order they are first reached, so that the
+  // assignment does not depend on pointer values.
+  llvm::DenseMap<const CallGraphNode *, unsigned> ComponentIndex;
+  SmallVector<unsigned, 32> ComponentOfNode;
+  SmallVector<unsigned, 32> ComponentSize;
+  for (const CallGraphNode *N : Order) {
+    if (!N->getDecl()) {
+      ComponentOfNode.push_back(0);
+      continue;
+    }
+    auto Inserted = ComponentIndex.insert(
+        {Components.getLeaderValue(N), ComponentSize.size()});
+    if (Inserted.second)
+      ComponentSize.push_back(0);
+    ComponentOfNode.push_back(Inserted.first->second);
+    ++ComponentSize[Inserted.first->second];
+  }
+
+  SmallVector<unsigned, 32> BySize(ComponentSize.size());
+  for (unsigned I = 0, E = BySize.size(); I != E; ++I)
+    BySize[I] = I;
+  std::stable_sort(BySize.begin(), BySize.end(), [&](unsigned L, unsigned R) {
+    return ComponentSize[L] > ComponentSize[R];
+  });
+
+  SmallVector<unsigned, 8> ShardSize(ShardCount, 0);
+  llvm::BitVector InShard(ComponentSize.size());
+  for (unsigned C : BySize) {
+    auto Smallest = std::min_element(ShardSize.begin(), ShardSize.end());
+    *Smallest += ComponentSize[C];
+    if (unsigned(Smallest - ShardSize.begin()) == ShardIndex)
+      InShard.set(C);
+  }
+
+  llvm::SmallPtrSet<const Decl *, 32> Decls;
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    if (Order[I]->getDecl() && InShard.test(ComponentOfNode[I]))
+      Decls.insert(Order[I]->getDecl());
+  return Decls;
+}
+
+std::string AnalysisConsumer::computeOptionsHash(CompilerInstance &CI) {
+  llvm::MD5 Hash;
+  // Covers the compiler version, the target and the language options.
+  Hash.update(CI.getInvocation().getModuleHash());
+
+  // Where the cache is does not affect the results, and runs that use copies
+  // of the cache in different places should share entries.
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Entry : Opts->Config)
+    if (Entry.getKey() != "incremental-cache-dir")
+      Config.emplace_back(Entry.getKey(), Entry.getValue());
+  llvm::sort(Config.begin(), Config.end());
+  for (const auto &Entry : Config) {
+    Hash.update(Entry.first);
+    Hash.update("=");
+    Hash.update(Entry.second);
+    Hash.update(";");
+  }
+  for (const auto &Checker : Opts->CheckersControlList) {
+    Hash.update(Checker.first);
+    Hash.update(Checker.second ? "+" : "-");
+  }
+  Hash.update(llvm::utostr(Opts->AnalysisStoreOpt) + ";" +
+              llvm::utostr(Opts->AnalysisConstraintsOpt) + ";" +
+              llvm::utostr(Opts->AnalysisPurgeOpt) + ";" +
+              llvm::utostr(Opts->maxBlockVisitOnPath) + ";" +
+              llvm::utostr(Opts->InlineMaxStackDepth) + ";" +
+              llvm::utostr(Opts->AnalyzeAll) + ";" +
+              llvm::utostr(Opts->eagerlyAssumeBinOpBifurcation));
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+namespace {
+/// Hashes what the analysis of a root function may depend on for the key of
+/// the incremental analysis cache: the bodies of the functions in its call
+/// graph, and the types, globals and other functions they refer to.
+///
+/// The ODR hash of a function is not used, because it leaves out the bodies
+/// of specializations. The bodies are hashed with an ODRHash instead, which
+/// refers to other declarations only by name; their definitions are added
+/// separately as they are found.
+class IncrementalCacheHasher
+    : public RecursiveASTVisitor<IncrementalCacheHasher> {
+  llvm::MD5 &Hash;
+  PrintingPolicy Policy;
+  llvm::SmallPtrSet<const Decl *, 32> Hashed;
+
+public:
+  IncrementalCacheHasher(llvm::MD5 &Hash, const ASTContext &Ctx)
+      : Hash(Hash), Policy(Ctx.getPrintingPolicy()) {}
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  /// Add the function \p D of the call graph. Returns false if \p D can't be
+  /// hashed.
+  bool addFunction(const Decl *D);
+
+  bool VisitExpr(Expr *E) {
+    addType(E->getType());
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    addReferencedDecl(E->getDecl());
+    return true;
+  }
+
+  bool VisitMemberExpr(MemberExpr *E) {
+    addReferencedDecl(E->getMemberDecl());
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *E) {
+    addReferencedDecl(E->getConstructor());
+    return true;
+  }
+
+  bool VisitValueDecl(ValueDecl *D) {
+    addType(D->getType());
+    return true;
+  }
+
+private:
+  void addString(StringRef S) {
+    Hash.update(llvm::utostr(S.size()) + ":");
+    Hash.update(S);
+  }
+
+  void addODRHash(ODRHash &H) { addString(llvm::utostr(H.CalculateHash())); }
+
+  void addAttrs(const Decl *D);
+  void addType(QualType T);
+  void addReferencedDecl(const Decl *D);
+};
+} // end anonymous namespace
+
+bool IncrementalCacheHasher::addFunction(const Decl *D) {
+  const auto *FD = dyn_cast<FunctionDecl>(D);
+  const FunctionDecl *Def;
+  if (!FD || !FD->hasBody(Def))
+    return false;
+
+  SmallString<128> USR;
+  if (index::generateUSRForDecl(D, USR))
+    return false;
+  addString(USR);
+
+  Hashed.insert(Def->getCanonicalDecl());
+  ODRHash H;
+  H.AddSubDecl(Def);
+  if (const auto *Ctor = dyn_cast<CXXConstructorDecl>(Def)) {
+    for (const CXXCtorInitializer *Init : Ctor->inits()) {
+      if (const FieldDecl *Member = Init->getAnyMember())
+        H.AddDecl(Member);
+      else if (const Type *Base = Init->getBaseClass())
+        H.AddType(Base);
+      H.AddStmt(Init->getInit());
+    }
+  }
+  H.AddStmt(Def->getBody());
+  addODRHash(H);
+  addAttrs(Def);
+
+  // Collect the definitions the body refers to.
+  TraverseDecl(const_cast<FunctionDecl *>(Def));
+  return true;
+}
+
+void IncrementalCacheHasher::addAttrs(const Decl *D) {
+  // Attributes are inherited by later redeclarations.
+  D = D->getMostRecentDecl();
+  for (const Attr *A : D->attrs()) {
+    SmallString<64> Str;
+    llvm::raw_svector_ostream OS(Str);
+    A->printPretty(OS, Policy);
+    addString(llvm::utostr(A->getKind()) + ":" + Str.str());
+  }
+}
+
+void IncrementalCacheHasher::addType(QualType T) {
+  while (true) {
+    if (T.isNull())
+      return;
+    T = T.getCanonicalType();
+    if (!T->getPointeeType().isNull())
+      T = T->getPointeeType();
+    else if (const ArrayType *AT = T->getAsArrayTypeUnsafe())
+      T = AT->getElementType();
+    else
+      break;
+  }
+
+  if (const auto *FT = T->getAs<FunctionProtoType>()) {
+    addType(FT->getReturnType());
+    for (QualType Param : FT->getParamTypes())
+      addType(Param);
+    return;
+  }
+
+  const TagDecl *TD = T->getAsTagDecl();
+  if (!TD || !Hashed.insert(TD->getCanonicalDecl()).second)
+    return;
+
+  ODRHash H;
+  H.AddQualType(T);
+  const TagDecl *Def = TD->getDefinition();
+  H.AddBoolean(Def);
+  if (!Def) {
+    addODRHash(H);
+    return;
+  }
+
+  SmallVector<QualType, 8> Nested;
+  if (const auto *RD = dyn_cast<RecordDecl>(Def)) {
+    if (const auto *CRD = dyn_cast<CXXRecordDecl>(RD)) {
+      for (const CXXBaseSpecifier &Base : CRD->bases()) {
+        H.AddBoolean(Base.isVirtual());
+        H.AddQualType(Base.getType());
+        Nested.push_back(Base.getType());
+      }
+    }
+    for (const FieldDecl *Field : RD->fields()) {
+      H.AddSubDecl(Field);
+      Nested.push_back(Field->getType());
+    }
+  } else if (const auto *ED = dyn_cast<EnumDecl>(Def)) {
+    H.AddQualType(ED->getIntegerType());
+    for (const EnumConstantDecl *Enumerator : ED->enumerators()) {
+      H.AddDecl(Enumerator);
+      addString(Enumerator->getInitVal().toString(10));
+    }
+  }
+  addODRHash(H);
+  addAttrs(Def);
+
+  for (QualType NestedT : Nested)
+    addType(NestedT);
+}
+
+void IncrementalCacheHasher::addReferencedDecl(const Decl *D) {
+  if (!D || !Hashed.insert(D->getCanonicalDecl()).second)
+    return;
+
+  // Functions with bodies are part of the call graph, but their declarations
+  // still matter where they are only called through a pointer or not inlined.
+  if (const auto *FD = dyn_cast<FunctionDecl>(D)) {
+    ODRHash H;
+    H.AddSubDecl(FD);
+    addODRHash(H);
+    addAttrs(FD);
+    addType(FD->getType());
+    return;
+  }
+
+  // The analysis uses the initial values of global constants and of static
+  // local variables.
+  if (const auto *VD = dyn_cast<VarDecl>(D)) {
+    if (!VD->hasGlobalStorage())
+      return;
+    const VarDecl *InitDecl = VD;
+    const Expr *Init = VD->getAnyInitializer(InitDecl);
+    ODRHash H;
+    H.AddSubDecl(InitDecl);
+    addODRHash(H);
+    addAttrs(InitDecl);
+    if (Init)
+      TraverseStmt(const_cast<Expr *>(Init));
+    return;
+  }
+
+  if (const auto *ECD = dyn_cast<EnumConstantDecl>(D))
+    addType(ECD->getType());
+}
+
+/// The declaration that ExprEngine records the function summary of \p D
+/// for, i.e. the one with the body.
+static const Decl *getSummaryDecl(const Decl *D) {
+  const FunctionDecl *Def;
+  if (const auto *FD = dyn_cast<FunctionDecl>(D))
+    if (FD->hasBody(Def))
+      return Def;
+  return D;
+}
+
+std::string AnalysisConsumer::getFunctionHash(const Decl *D) {
+  auto Inserted = FunctionHashes.insert({D, std::string()});
+  if (!Inserted.second)
+    return Inserted.first->second;
+
+  llvm::MD5 Hash;
+  IncrementalCacheHasher Hasher(Hash, *Ctx);
+  if (!Hasher.addFunction(D))
+    return std::string();
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  Inserted.first->second = Str.str();
+  return Str.str();
+}
+
+bool AnalysisConsumer::getIncrementalCacheKey(CallGraphNode *N,
+                                              SmallVectorImpl<char> &Key,
+                                              SetOfConstDecls &Dependencies) {
+  llvm::MD5 Hash;
+  Hash.update(OptionsHash);
+
+  SmallVector<CallGraphNode *, 16> Worklist;
+  Worklist.push_back(N);
+  Dependencies.insert(N->getDecl());
+  while (!Worklist.empty()) {
+    CallGraphNode *Current = Worklist.pop_back_val();
+    std::string FunctionHash = getFunctionHash(Current->getDecl());
+    if (FunctionHash.empty())
+      return false;
+    Hash.update(FunctionHash);
+
+    // Whether and how often the earlier roots inlined the function decides
+    // whether this root inlines it, e.g. with max-times-inline-large.
+    const Decl *SummaryDecl = getSummaryDecl(Current->getDecl());
+    unsigned TimesInlined = FunctionSummaries.getNumTimesInlined(SummaryDecl);
+    Optional<bool> MayInline = FunctionSummaries.mayInline(SummaryDecl);
+    Hash.update(llvm::utostr(TimesInlined) +
+                (!MayInline ? "?" : *MayInline ? "y" : "n") + ";");
+
+    for (CallGraphNode *Callee : *Current)
+      if (Dependencies.insert(Callee->getDecl()).second)
+        Worklist.push_back(Callee);
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  Key.assign(Str.begin(), Str.end());
+  return true;
+}
+
+namespace {
+/// A function inlined into a root in the incremental analysis cache, with
+/// the changes the analysis of the root made to its function summary. Later
+/// roots decide what to inline based on these, so they are replayed when the
+/// root is skipped.
+struct CachedCallee {
+  std::string USR;
+  unsigned TimesInlined;
+  /// Whether the function was marked as one that may or may not be inlined,
+  /// or None if the mark did not change.
+  Optional<bool> MarkedMayInline;
+};
+} // end anonymous namespace
+
+/// Read the functions inlined into the root with the given \p Key from the
+/// incremental analysis cache. Returns false if there is no valid entry for
+/// the key.
+static bool readIncrementalCacheEntry(StringRef Dir, StringRef Key,
+                                      std::vector<CachedCallee> &Callees) {
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, Key);
+  auto Buffer = llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return false;
+
+  // Each line holds the number of times the callee was inlined, 'y' or 'n' if
+  // it was marked as one that may or may not be inlined or '-' otherwise, and
+  // its USR, separated by tabs.
+  SmallVector<StringRef, 16> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    StringRef Times, Flag, USR;
+    std::tie(Times, Line) = Line.split('\t');
+    std::tie(Flag, USR) = Line.split('\t');
+    CachedCallee Callee;
+    if (Times.getAsInteger(10, Callee.TimesInlined) ||
+        (Flag != "y" && Flag != "n" && Flag != "-") || USR.empty())
+      return false;
+    Callee.USR = USR;
+    if (Flag != "-")
+      Callee.MarkedMayInline = Flag == "y";
+    Callees.push_back(std::move(Callee));
+  }
+  return true;
+}
+
+/// Record that the root with the given \p Key was analyzed without finding
+/// bugs, and which functions were inlined into it. The entry is written under
+/// a temporary name and renamed, so concurrent analyses never see a partial
+/// entry.
+static void writeIncrementalCacheEntry(StringRef Dir, StringRef Key,
+                                       ArrayRef<CachedCallee> Callees) {
+  SmallString<128> TempPath(Dir);
+  llvm::sys::path::append(TempPath, Key + "-%%%%%%%%.tmp");
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath))
+    return;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    for (const CachedCallee &Callee : Callees)
+      OS << Callee.TimesInlined << '\t'
+         << (!Callee.MarkedMayInline ? '-'
+                                     : *Callee.MarkedMayInline ? 'y' : 'n')
+         << '\t' << Callee.USR << '\n';
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, Key);
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
 ExprEngine::InliningModes
 AnalysisConsumer::getInliningModeForFunction(const Decl *D,
                                              const SetOfConstDecls &Visited) {
@@ -484,28 +992,130 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   SetOfConstDecls Visited;
   SetOfConstDecls VisitedAsTopLevel;
   llvm::ReversePostOrderTraversal<clang::CallGraph*> RPOT(&CG);
-  for (llvm::ReversePostOrderTraversal<clang::CallGraph*>::rpo_iterator
-         I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
+  SmallVector<CallGraphNode *, 64> Order(RPOT.begin(), RPOT.end());
+
+  // When the analysis is split between several invocations, only analyze the
+  // functions of this one's shard.
+  unsigned ShardCount = Opts->getAnalysisShardCount();
+  llvm::SmallPtrSet<const Decl *, 32> DeclsInShard;
+  if (ShardCount > 1)
+    DeclsInShard =
+        getDeclsInShard(Order, ShardCount, Opts->getAnalysisShardIndex());
+
+  // The incremental analysis cache records which functions were inlined into
+  // a root, so it can only be used when the analysis tracks them.
+  StringRef CacheDir = Mgr->options.InliningMode != All
+                           ? Opts->getIncrementalCacheDir()
+                           : StringRef();
+  llvm::StringMap<const Decl *> DeclsByUSR;
+
+  for (CallGraphNode *N : Order) {
     NumFunctionTopLevel++;
 
-    CallGraphNode *N = *I;
     Decl *D = N->getDecl();
 
     // Skip the abstract root node.
     if (!D)
       continue;
 
+    // Skip the functions analyzed by other shards.
+    if (ShardCount > 1 && !DeclsInShard.count(D))
+      continue;
+
     // Skip the functions which have been processed already or previously
     // inlined.
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
+    // Skip the functions that are unchanged, together with everything they
+    // may call, since an earlier analysis found no bugs in them. Consider the
+    // functions inlined into them back then as inlined again.
+    SmallString<32> CacheKey;
+    SetOfConstDecls Dependencies;
+    bool UseCache = !CacheDir.empty() &&
+                    getIncrementalCacheKey(N, CacheKey, Dependencies);
+    std::vector<CachedCallee> Callees;
+    if (UseCache && readIncrementalCacheEntry(CacheDir, CacheKey, Callees)) {
+      if (DeclsByUSR.empty()) {
+        for (const auto &Node : CG) {
+          SmallString<128> USR;
+          if (!index::generateUSRForDecl(Node.first, USR))
+            DeclsByUSR[USR] = Node.first;
+        }
+      }
+      for (const CachedCallee &Cached : Callees) {
+        const Decl *Callee = DeclsByUSR.lookup(Cached.USR);
+        if (!Callee)
+          continue;
+        const Decl *SummaryDecl = getSummaryDecl(Callee);
+        for (unsigned I = 0; I != Cached.TimesInlined; ++I)
+          FunctionSummaries.bumpNumTimesInlined(SummaryDecl);
+        if (Cached.MarkedMayInline.hasValue()) {
+          if (*Cached.MarkedMayInline)
+            FunctionSummaries.markMayInline(SummaryDecl);
+          else
+            FunctionSummaries.markShouldNotInline(SummaryDecl);
+        }
+        if (Cached.TimesInlined)
+          Visited.insert(isa<ObjCMethodDecl>(Callee)
+                             ? Callee
+                             : Callee->getCanonicalDecl());
+      }
+      VisitedAsTopLevel.insert(D);
+      NumFunctionsUnchanged++;
+      continue;
+    }
+
+    // Remember the summaries of the functions that may be inlined, to record
+    // how the analysis changes them.
+    llvm::DenseMap<const Decl *, std::pair<unsigned, Optional<bool>>>
+        SummariesBefore;
+    if (UseCache) {
+      for (const Decl *Dependency : Dependencies) {
+        const Decl *SummaryDecl = getSummaryDecl(Dependency);
+        SummariesBefore[SummaryDecl] = {
+            FunctionSummaries.getNumTimesInlined(SummaryDecl),
+            FunctionSummaries.mayInline(SummaryDecl)};
+      }
+    }
+
     // Analyze the function.
     SetOfConstDecls VisitedCallees;
 
+    EmittedPathReports = false;
     HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
                (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
 
+    // Only record the functions that are known to have no bugs, and whose
+    // inlined callees were all part of the key. Callees reached through
+    // dynamic dispatch may not have been.
+    if (UseCache && !EmittedPathReports &&
+        llvm::all_of(VisitedCallees, [&](const Decl *Callee) {
+          return SummariesBefore.count(Callee);
+        })) {
+      // Record every summary the analysis changed, including those of the
+      // functions it decided not to inline, since they are part of the keys
+      // of the later roots.
+      Callees.clear();
+      for (const auto &Before : SummariesBefore) {
+        const Decl *Callee = Before.first;
+        CachedCallee Cached;
+        Cached.TimesInlined = FunctionSummaries.getNumTimesInlined(Callee) -
+                              Before.second.first;
+        Optional<bool> MayInline = FunctionSummaries.mayInline(Callee);
+        if (MayInline != Before.second.second)
+          Cached.MarkedMayInline = MayInline;
+        if (!Cached.TimesInlined && !Cached.MarkedMayInline)
+          continue;
+        SmallString<128> USR;
+        if (index::generateUSRForDecl(Callee, USR))
+          continue;
+        Cached.USR = USR.str();
+        Callees.push_back(std::move(Cached));
+      }
+      writeIncrementalCacheEntry(CacheDir, CacheKey, Callees);
+    }
+
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
       // Decls from CallGraph are already canonical. But Decls coming from
@@ -528,13 +1138,20 @@ static bool isBisonFile(ASTContext &C) {
 void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
   BugReporter BR(*Mgr);
   TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-  checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+
+  // When the analysis is split between several invocations, the first one
+  // runs all the AST-only checks, and, without inlining, all the path
+  // sensitive ones.
+  bool IsFirstShard = Opts->getAnalysisShardCount() == 1 ||
+                      Opts->getAnalysisShardIndex() == 0;
+  if (IsFirstShard)
+    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
   // Run the AST-only checks using the order in which functions are defined.
   // If inlining is not turned on, use the simplest function order for path
   // sensitive analyzes as well.
-  RecVisitorMode = AM_Syntax;
-  if (!Mgr->shouldInlineCall())
+  RecVisitorMode = IsFirstShard ? AM_Syntax : AM_None;
+  if (!Mgr->shouldInlineCall() && IsFirstShard)
     RecVisitorMode |= AM_Path;
   RecVisitorBR = &BR;
 
@@ -545,15 +1162,18 @@ void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
   // random access.  By doing so, we automatically compensate for iterators
   // possibly being invalidated, although this is a bit slower.
   const unsigned LocalTUDeclsSize = LocalTUDecls.size();
-  for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
-    TraverseDecl(LocalTUDecls[i]);
+  if (RecVisitorMode != AM_None) {
+    for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
+      TraverseDecl(LocalTUDecls[i]);
+    }
   }
 
   if (Mgr->shouldInlineCall())
     HandleDeclsCallGraph(LocalTUDeclsSize);
 
   // After all decls handled, run checkers on the entire TranslationUnit.
-  checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+  if (IsFirstShard)
+    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
   RecVisitorBR = nullptr;
 }
@@ -586,6 +1206,9 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
 
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
+  if (Profiler)
+    reportAnalysisProfile();
+
   // Count how many basic blocks we have not covered.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
   NumVisitedBlocksInAnalyzedFunctions =
@@ -602,6 +1225,25 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   Mgr.reset();
 }
 
+void AnalysisConsumer::reportAnalysisProfile() {
+  auto GetName = [this](const Decl *D) { return getFunctionName(D); };
+  if (Opts->shouldProfileAnalysis())
+    Profiler->printTable(llvm::errs(), GetName);
+
+  StringRef OutputFile = Opts->getAnalysisProfileOutput();
+  if (OutputFile.empty())
+    return;
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    llvm::errs() << "warning: could not create file '" << OutputFile
+                 << "': " << EC.message() << '\n';
+    return;
+  }
+  Profiler->printJSON(OS, GetName);
+}
+
 std::string AnalysisConsumer::getFunctionName(const Decl *D) {
   std::string Str;
   llvm::raw_string_ostream OS(Str);
@@ -745,8 +1387,10 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   }
 
   // Execute the worklist algorithm.
+  AnalysisProfiler::Clock::time_point Start = AnalysisProfiler::Clock::now();
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
                       Mgr->options.getMaxNodesPerTopLevelFunction());
+  double Seconds = AnalysisProfiler::secondsSince(Start);
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
@@ -757,7 +1401,15 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
+  Start = AnalysisProfiler::Clock::now();
   Eng.getBugReporter().FlushReports();
+  if (Profiler) {
+    Seconds += AnalysisProfiler::secondsSince(Start);
+    Profiler->addFunctionCost(D, Seconds, Eng.getGraph().size());
+  }
+  if (Eng.getBugReporter().EQClasses_begin() !=
+      Eng.getBugReporter().EQClasses_end())
+    EmittedPathReports = true;
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
@@ -0,0 +1,24 @@
+// REQUIRES: asserts
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats -analyzer-config graph-trim-interval=1,aggressive-graph-trimming=true %s 2>&1 | FileCheck %s -check-prefix=AGGRESSIVE
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats -analyzer-config graph-trim-interval=1 %s 2>&1 | FileCheck %s -check-prefix=DEFAULT
+
+// Nodes that are still on the frontier when the graph is trimmed are only
+// reclaimed later with aggressive-graph-trimming.
+
+int getValue(int x) {
+  return x + 1;
+}
+
+int test(int x) {
+  int y = getValue(x);
+  int z = y * 2 + x;
+  if (z > y)
+    return z - y;
+  return y - z;
+}
+
+// AGGRESSIVE: ... Statistics Collected ...
+// AGGRESSIVE: {{[1-9][0-9]*}} ExplodedGraph - The # of nodes reclaimed after being on the frontier
+
+// DEFAULT: ... Statistics Collected ...
+// DEFAULT-NOT: ExplodedGraph - The # of nodes reclaimed after being on the frontier
@@ -0,0 +1,18 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config graph-trim-interval=1,aggressive-graph-trimming=true -analyzer-output=text -verify %s
+
+// Reclaiming nodes once they get a successor must keep the nodes the path
+// notes are built from.
+
+int getValue(int x) {
+  return x + 1;
+}
+
+void test(int x) {
+  int *p = 0; // expected-note{{'p' initialized to a null pointer value}}
+  int y = getValue(x);
+  if (y) { // expected-note{{Assuming 'y' is not equal to 0}}
+           // expected-note@-1{{Taking true branch}}
+    *p = y; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+            // expected-note@-1{{Dereference of null pointer (loaded from variable 'p')}}
+  }
+}
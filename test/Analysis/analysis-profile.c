@@ -0,0 +1,37 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config profile-analysis=true,profile-analysis-output=%t.json \
+// RUN:   -verify %s 2>&1 | FileCheck %s
+// RUN: FileCheck --input-file=%t.json %s --check-prefix=JSON
+
+int callee(int x) {
+  return x + 1;
+}
+
+int test(int y) {
+  int z = callee(y);
+  int d = 0;
+  return z / d; // expected-warning{{Division by zero}}
+}
+
+// CHECK: Analyzer checker costs, excluding nested checker callbacks
+// CHECK: Time (s) Nodes Calls Checker
+// CHECK: {{[0-9]+\.[0-9]+ +[0-9]+ +[1-9][0-9]*}} core.DivideZero
+// CHECK: Analyzer top-level function costs
+// CHECK-NEXT: ===
+// CHECK-NEXT: Time (s) Nodes Analyses Function
+// CHECK-NEXT: {{[0-9]+\.[0-9]+ +[1-9][0-9]* +1}} test
+// CHECK-NEXT: ===
+// CHECK-NEXT: Analyzer inlined callee costs
+// CHECK-NEXT: ===
+// CHECK-NEXT: Time (s) Nodes Steps Inlined Not inlined Callee
+// CHECK-NEXT: {{[0-9]+\.[0-9]+ +[0-9]+ +[1-9][0-9]* +1 +0}} callee
+
+// JSON: "checkers": [
+// JSON: {"name": "core.DivideZero", "seconds": {{[0-9.]+}}, "nodes": {{[0-9]+}}, "calls": {{[1-9][0-9]*}}}
+// JSON: "functions": [
+// JSON-NEXT: {"name": "test", "seconds": {{[0-9.]+}}, "nodes": {{[1-9][0-9]*}}, "analyses": 1}
+// JSON-NEXT: ],
+// JSON-NEXT: "callees": [
+// JSON-NEXT: {"name": "callee", "seconds": {{[0-9.]+}}, "nodes": {{[0-9]+}}, "steps": {{[1-9][0-9]*}}, "inlined": 1, "not-inlined": 0}
+// JSON-NEXT: ]
+// JSON-NEXT: }
@@ -0,0 +1,33 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores -verify=shard0,shard1 %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores -analyzer-config analysis-shard-count=2,analysis-shard-index=0 -verify=shard0 %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores -analyzer-config analysis-shard-count=2,analysis-shard-index=1 -verify=shard1 %s
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-shard-count=2,analysis-shard-index=2 %s 2>&1 | FileCheck %s -check-prefix=OUT-OF-RANGE
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core -analyzer-config analysis-shard-index=1 %s 2>&1 | FileCheck %s -check-prefix=NO-COUNT
+
+// OUT-OF-RANGE: error: analyzer-config option 'analysis-shard-index=2' is out of range; it must be less than 'analysis-shard-count' (2)
+// NO-COUNT: error: analyzer-config option 'analysis-shard-index=1' is out of range; it must be less than 'analysis-shard-count' (1)
+
+// The call graph has three components, {caller, helper}, {divide} and
+// {store}. The largest one goes to the first shard and the two others to the
+// second shard. Checks that are not path sensitive only run in the first
+// shard.
+
+int helper(int *p) {
+  return *p; // shard0-warning{{Dereference of null pointer (loaded from variable 'p')}}
+}
+
+int caller() {
+  return helper(0);
+}
+
+void divide() {
+  int x = 0;
+  int y;
+  y = 1 / x; // shard1-warning{{Division by zero}}
+             // shard0-warning@-1{{Value stored to 'y' is never read}}
+}
+
+void store() {
+  int *p = 0;
+  *p = 1; // shard1-warning{{Dereference of null pointer (loaded from variable 'p')}}
+}
@@ -0,0 +1,36 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=text -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=text -analyzer-config batch-report-graphs=true -verify %s
+
+// The paths of all the reports of a function are generated from one trimmed
+// graph.
+
+void nullDeref(int x) {
+  int *p = 0; // expected-note{{'p' initialized to a null pointer value}}
+  if (x) // expected-note{{Assuming 'x' is not equal to 0}}
+         // expected-note@-1{{Taking true branch}}
+    *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+            // expected-note@-1{{Dereference of null pointer (loaded from variable 'p')}}
+}
+
+int divZero(int x) {
+  int y = 0; // expected-note{{'y' initialized to 0}}
+  if (x > 1) // expected-note{{Assuming 'x' is > 1}}
+             // expected-note@-1{{Taking true branch}}
+    return x / y; // expected-warning{{Division by zero}}
+                  // expected-note@-1{{Division by zero}}
+  return 0;
+}
+
+void twoReports(int x) {
+  int *p = 0; // expected-note 2 {{'p' initialized to a null pointer value}}
+  if (x) { // expected-note{{Assuming 'x' is not equal to 0}}
+           // expected-note@-1{{Taking true branch}}
+           // expected-note@-2{{Assuming 'x' is 0}}
+           // expected-note@-3{{Taking false branch}}
+    *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+            // expected-note@-1{{Dereference of null pointer (loaded from variable 'p')}}
+  } else {
+    p[1] = 2; // expected-warning{{Array access (from variable 'p') results in a null pointer dereference}}
+              // expected-note@-1{{Array access (from variable 'p') results in a null pointer dereference}}
+  }
+}
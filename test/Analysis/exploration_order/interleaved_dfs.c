@@ -0,0 +1,38 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=debug.ExprInspection -analyzer-config exploration_strategy=dfs,max-nodes=1000 %s 2>&1 | FileCheck %s -check-prefix=DFS
+// RUN: %clang_analyze_cc1 -analyzer-checker=debug.ExprInspection -analyzer-config exploration_strategy=interleaved_dfs,max-nodes=1000 %s 2>&1 | FileCheck %s -check-prefix=INTERLEAVED
+
+// Each branch has more paths than the node budget allows. Plain DFS spends
+// the whole budget in the first branch it enters, while the interleaved
+// searches also reach the other one.
+
+// DFS: 1 warning generated.
+// INTERLEAVED: 2 warnings generated.
+
+void clang_analyzer_warnIfReached();
+int coin();
+
+#define EXPLODE(x)                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;                                                             \
+  if (coin()) x++;
+
+int test(int a) {
+  int x = 0;
+  if (a) {
+    clang_analyzer_warnIfReached();
+    EXPLODE(x)
+  } else {
+    clang_analyzer_warnIfReached();
+    EXPLODE(x)
+  }
+  return x;
+}
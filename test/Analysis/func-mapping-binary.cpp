@@ -0,0 +1,9 @@
+// RUN: %clang_func_map -binary-output=%t.bin %s -- | count 0
+// RUN: FileCheck %s < %t.bin
+
+int f(int) {
+  return 0;
+}
+
+// CHECK: CTUIDX01
+// CHECK: c:@F@f#I#
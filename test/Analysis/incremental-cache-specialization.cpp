@@ -0,0 +1,48 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t.dir && mkdir %t.dir %t.dir/cache
+// RUN: cp %s %t.dir/input.cpp
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir/cache -verify \
+// RUN:   %t.dir/input.cpp 2>&1 | FileCheck %s -check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir/cache -verify \
+// RUN:   %t.dir/input.cpp 2>&1 | FileCheck %s -check-prefix=SECOND
+
+// Editing the body of an explicit specialization, or a global that a root
+// reads, must invalidate the roots that depend on it.
+// RUN: sed -e 's/return \*p; \/\/ specialization/return *p + 0;/' %s \
+// RUN:   > %t.dir/input.cpp
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir/cache -verify \
+// RUN:   %t.dir/input.cpp 2>&1 | FileCheck %s -check-prefix=EDITED
+// RUN: sed -e 's/Limit = 10;/Limit = 20;/' %s > %t.dir/input.cpp
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir/cache -verify \
+// RUN:   %t.dir/input.cpp 2>&1 | FileCheck %s -check-prefix=EDITED
+
+// expected-no-diagnostics
+
+template <typename T> struct Box {
+  int get(int *p) { return *p; }
+};
+
+template <> struct Box<char> {
+  int get(int *p) {
+    return *p; // specialization
+  }
+};
+
+int useSpecialization(int x) {
+  Box<char> B;
+  return B.get(&x);
+}
+
+const int Limit = 10;
+
+int useGlobal(int x) {
+  return x < Limit ? x : Limit;
+}
+
+// FIRST-NOT: AnalysisConsumer - The # of functions not analyzed because they
+// SECOND: 2 AnalysisConsumer - The # of functions not analyzed because they
+// EDITED: 1 AnalysisConsumer - The # of functions not analyzed because they
@@ -0,0 +1,37 @@
+// RUN: rm -rf %t.dir && mkdir %t.dir
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=ANALYZED
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CACHED
+
+// second() is unchanged, but first(), which is analyzed before it, now
+// inlines helper() more often. That changes the function summary of helper()
+// that second() starts from, so second() must be analyzed again.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir -DINLINE_TWICE %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=ANALYZED
+
+// ANALYZED: (Path, {{.*}}): {{.*}} first
+// ANALYZED: (Path, {{.*}}): {{.*}} second
+
+// Skipping first() replays its changes to the summary of helper(), so the
+// key of second() matches again.
+// CACHED-NOT: (Path,
+
+int helper(int x) {
+  return x + 1;
+}
+
+// Roots are analyzed in the reverse order of their declarations.
+int second(int x) {
+  return helper(x);
+}
+
+int first(int x) {
+#ifdef INLINE_TWICE
+  x = helper(x);
+#endif
+  return helper(x);
+}
@@ -0,0 +1,29 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t.dir && mkdir %t.dir
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir -verify %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config incremental-cache-dir=%t.dir -verify %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=SECOND
+
+int getValue(int *p) {
+  return *p;
+}
+
+int noBugs(int x) {
+  int y = x;
+  return getValue(&y);
+}
+
+int hasBug(int x) {
+  int *p = 0;
+  if (x)
+    return 0;
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
+
+// Only noBugs() is cached. hasBug() is analyzed again to emit its report, and
+// getValue() is still considered inlined into noBugs().
+// FIRST-NOT: AnalysisConsumer - The # of functions not analyzed because they
+// SECOND: 1 AnalysisConsumer - The # of functions not analyzed because they
@@ -0,0 +1,26 @@
+// REQUIRES: z3, asserts
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-constraints=z3 -analyzer-stats -verify %s 2>&1 \
+// RUN:   | FileCheck %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-config crosscheck-with-z3=true -verify %s
+
+void clang_analyzer_eval(int);
+
+void repeated(int x) {
+  if (x > 10) {
+    clang_analyzer_eval(x > 5); // expected-warning{{TRUE}}
+    // The constraints are the same, so the queries are not solved again.
+    clang_analyzer_eval(x > 5); // expected-warning{{TRUE}}
+  }
+}
+
+void infeasible(int x, int y) {
+  int *p = 0;
+  if ((x & 1) && ((x & 1) ^ 1))
+    *p = y; // no-warning
+  if ((y & 1) && ((y & 1) ^ 1))
+    *p = x; // no-warning
+}
+
+// CHECK: {{[1-9][0-9]*}} Z3ConstraintManager - The # of satisfiability queries answered from the query cache
@@ -0,0 +1,70 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/first0.o \
+// RUN:   -parallel-codegen-output %t/first1.o \
+// RUN:   -fparallel-codegen-cache-path=%t/cache \
+// RUN:   -Rparallel-codegen-cache 2>&1 \
+// RUN:   | FileCheck -check-prefix=MISS %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/second0.o \
+// RUN:   -parallel-codegen-output %t/second1.o \
+// RUN:   -fparallel-codegen-cache-path=%t/cache \
+// RUN:   -Rparallel-codegen-cache 2>&1 \
+// RUN:   | FileCheck -check-prefix=HIT %s
+// RUN: cmp %t/first0.o %t/second0.o
+// RUN: cmp %t/first1.o %t/second1.o
+
+// A different option must not reuse the cached code, including the options
+// that are passed to the backend with -mllvm.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/third0.o \
+// RUN:   -parallel-codegen-output %t/third1.o -ffunction-sections \
+// RUN:   -fparallel-codegen-cache-path=%t/cache \
+// RUN:   -Rparallel-codegen-cache 2>&1 \
+// RUN:   | FileCheck -check-prefix=MISS %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/fourth0.o \
+// RUN:   -parallel-codegen-output %t/fourth1.o -mllvm -align-all-functions=6 \
+// RUN:   -fparallel-codegen-cache-path=%t/cache \
+// RUN:   -Rparallel-codegen-cache 2>&1 \
+// RUN:   | FileCheck -check-prefix=MISS %s
+
+// MISS-DAG: remark: generating code for module partition 0
+// MISS-DAG: remark: generating code for module partition 1
+// HIT-DAG: remark: reusing cached code for module partition 0
+// HIT-DAG: remark: reusing cached code for module partition 1
+
+// The cache only holds partitions, so it is rejected without them.
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen-cache-path=%t/single -o %t/single.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=SINGLE %s
+// RUN: not ls %t/single
+
+// SINGLE: invalid argument '-fparallel-codegen-cache-path={{.*}}single' only allowed with '-fparallel-codegen=<N>'
+
+// The cache is pruned according to the policy.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/pruned0.o \
+// RUN:   -parallel-codegen-output %t/pruned1.o \
+// RUN:   -fparallel-codegen-cache-path=%t/pruned \
+// RUN:   -fparallel-codegen-cache-policy=prune_interval=0s:cache_size_files=1
+// RUN: ls %t/pruned | grep -v timestamp | count 1
+
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/bogus0.o \
+// RUN:   -parallel-codegen-output %t/bogus1.o \
+// RUN:   -fparallel-codegen-cache-path=%t/bogus \
+// RUN:   -fparallel-codegen-cache-policy=bogus 2>&1 \
+// RUN:   | FileCheck -check-prefix=POLICY %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/nocache0.o \
+// RUN:   -parallel-codegen-output %t/nocache1.o \
+// RUN:   -fparallel-codegen-cache-policy=prune_interval=0s 2>&1 \
+// RUN:   | FileCheck -check-prefix=NO-PATH %s
+
+// POLICY: invalid value 'bogus' in '-fparallel-codegen-cache-policy=bogus'
+// NO-PATH: invalid argument '-fparallel-codegen-cache-policy=prune_interval=0s' only allowed with '-fparallel-codegen-cache-path=<dir>'
+
+int square(int x) { return x * x; }
+int cube(int x) { return x * x * x; }
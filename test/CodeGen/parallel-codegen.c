@@ -0,0 +1,59 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -S %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.s \
+// RUN:   -parallel-codegen-output %t/part1.s
+// RUN: cat %t/part0.s %t/part1.s | FileCheck %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -S %s \
+// RUN:   -fparallel-codegen=3 -parallel-codegen-output %t/part0.s \
+// RUN:   -parallel-codegen-output %t/part1.s 2>&1 \
+// RUN:   | FileCheck -check-prefix=OUTPUTS %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -S %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.s \
+// RUN:   -parallel-codegen-output %t/part1.s -o %t/out.s 2>&1 \
+// RUN:   | FileCheck -check-prefix=OUTPUT %s
+
+// Partitions are only written for object files and assembly, with the legacy
+// pass manager, and outside of ThinLTO backend compiles.
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.ll \
+// RUN:   -parallel-codegen-output %t/part1.ll 2>&1 \
+// RUN:   | FileCheck -check-prefix=ACTION %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm-bc %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.bc \
+// RUN:   -parallel-codegen-output %t/part1.bc 2>&1 \
+// RUN:   | FileCheck -check-prefix=ACTION %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -S \
+// RUN:   -fexperimental-new-pass-manager %s \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.s \
+// RUN:   -parallel-codegen-output %t/part1.s 2>&1 \
+// RUN:   | FileCheck -check-prefix=NEWPM %s
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj -x ir %s \
+// RUN:   -fthinlto-index=%t/index.bc \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t/part0.o \
+// RUN:   -parallel-codegen-output %t/part1.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=THINLTO %s
+
+// OUTPUTS: '-fparallel-codegen=3' requires 3 '-parallel-codegen-output' files, but 2 were given
+// OUTPUT: invalid argument '-fparallel-codegen=2' not allowed with '-o'
+// ACTION: '-fparallel-codegen=2' is only supported when emitting an object file or assembly
+// NEWPM: invalid argument '-fparallel-codegen=2' not allowed with '-fexperimental-new-pass-manager'
+// THINLTO: invalid argument '-fparallel-codegen=2' not allowed with '-fthinlto-index={{.*}}index.bc'
+
+// Every function is emitted into exactly one partition, and static functions
+// stay local to the partition that uses them.
+
+// CHECK-NOT: .globl helper
+// CHECK-DAG: {{^}}helper:
+// CHECK-DAG: .globl a
+// CHECK-DAG: {{^}}a:
+// CHECK-DAG: .globl b
+// CHECK-DAG: {{^}}b:
+// CHECK-DAG: .globl c
+// CHECK-DAG: {{^}}c:
+
+__attribute__((noinline)) static int helper(int x) { return x * 3 + 1; }
+
+int a(int x) { return helper(x) + 1; }
+int b(int x) { return helper(x) - 1; }
+int c(int x) { return x / 7; }
@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -disable-llvm-passes %s -emit-llvm -o - | FileCheck %s -check-prefix=MANGLED
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -disable-llvm-passes %s -emit-llvm -hash-tbaa-type-names -o - | FileCheck %s -check-prefix=HASHED-OLD
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -disable-llvm-passes %s -emit-llvm -hash-tbaa-type-names -new-struct-path-tbaa -o - | FileCheck %s -check-prefix=HASHED-NEW
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -O1 -disable-llvm-passes %s -emit-llvm -hash-tbaa-type-names -o - | FileCheck %s -check-prefix=NO-MANGLED
+// Test that -hash-tbaa-type-names replaces the mangled names of C++ type nodes
+// with fixed-size hashes, and leaves the builtin type nodes alone.
+
+enum class Color { Red, Green };
+
+template <typename T, typename U> struct Pair {
+  T first;
+  U second;
+};
+
+int f(Pair<int, Color> *P) {
+  P->second = Color::Green;
+  return P->first;
+}
+
+// MANGLED-DAG: !{!"_ZTS4PairIi5ColorE",
+// MANGLED-DAG: !{!"_ZTS5Color",
+
+// NO-MANGLED-NOT: !"_ZTS
+
+// HASHED-OLD-DAG: !{!"tbaa.{{[0-9a-f]{16}}}", ![[INT:[0-9]+]], i64 0, ![[COLOR:[0-9]+]], i64 4}
+// HASHED-OLD-DAG: ![[COLOR]] = !{!"tbaa.{{[0-9a-f]{16}}}", !{{[0-9]+}}, i64 0}
+// HASHED-OLD-DAG: ![[INT]] = !{!"int", !{{[0-9]+}}, i64 0}
+// HASHED-NEW-DAG: !{!{{[0-9]+}}, i64 8, !"tbaa.{{[0-9a-f]{16}}}", ![[INT:[0-9]+]], i64 0, i64 4, ![[COLOR:[0-9]+]], i64 4, i64 4}
+// HASHED-NEW-DAG: ![[COLOR]] = !{!{{[0-9]+}}, i64 4, !"tbaa.{{[0-9a-f]{16}}}"}
+// HASHED-NEW-DAG: ![[INT]] = !{!{{[0-9]+}}, i64 4, !"int"}
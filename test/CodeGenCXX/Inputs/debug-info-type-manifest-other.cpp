@@ -0,0 +1,9 @@
+namespace ns {
+template <typename T> struct Box { T v; };
+}
+
+ns::Box<int> bi;
+ns::Box<float> bf;
+
+// OTHER-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Box<int>",{{.*}} flags: DIFlagFwdDecl
+// OTHER-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Box<float>",{{.*}} elements: !{{[0-9]+}}
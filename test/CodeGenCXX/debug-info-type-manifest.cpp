@@ -0,0 +1,43 @@
+// RUN: echo "# type home" > %t.manifest
+// RUN: printf 'ns::Homed\t%s\n' %s >> %t.manifest
+// RUN: printf 'ns::Elsewhere\tother dir/other.cpp\n' >> %t.manifest
+// RUN: printf 'ns::(anonymous namespace)::Internal\tother dir/other.cpp\n' >> %t.manifest
+// RUN: printf 'ns::Box<int>\t%s\n' %s >> %t.manifest
+// RUN: printf 'ns::Box<float>\t%s\n' %S/Inputs/debug-info-type-manifest-other.cpp >> %t.manifest
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm \
+// RUN:   -debug-info-kind=limited -fdebug-type-manifest=%t.manifest %s -o - \
+// RUN:   | FileCheck %s
+
+// Each specialization of a class template has its own home. The other
+// translation unit is the home of the specialization that only it uses.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm \
+// RUN:   -debug-info-kind=limited -fdebug-type-manifest=%t.manifest \
+// RUN:   %S/Inputs/debug-info-type-manifest-other.cpp -o - \
+// RUN:   | FileCheck %s --check-prefix=OTHER
+
+namespace ns {
+// Only used through a pointer, but this is its home.
+struct Homed { int x; };
+// Required to be complete, but its home is another translation unit.
+struct Elsewhere { int y; };
+// Not in the manifest; the usual heuristics apply.
+struct Unlisted { int z; };
+namespace {
+// Listed with another home, but every translation unit has its own copy of
+// this type, so the entry does not apply.
+struct Internal { int w; };
+}
+template <typename T> struct Box { T v; };
+}
+
+ns::Homed *p;
+ns::Elsewhere e;
+ns::Unlisted u;
+ns::Internal i;
+ns::Box<int> bi;
+
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Homed",{{.*}} elements: !{{[0-9]+}}
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Elsewhere",{{.*}} flags: DIFlagFwdDecl
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Unlisted",{{.*}} elements: !{{[0-9]+}}
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Internal",{{.*}} elements: !{{[0-9]+}}
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Box<int>",{{.*}} elements: !{{[0-9]+}}
@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm %s -o - \
+// RUN:   | FileCheck -check-prefix=CHECK -check-prefix=DEFAULT %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm %s -o %t.ll \
+// RUN:   -fprune-deferred-decls
+// RUN: FileCheck -check-prefix=CHECK %s < %t.ll
+// RUN: FileCheck -check-prefix=PRUNE %s < %t.ll
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm %s -o /dev/null \
+// RUN:   -fprune-deferred-decls -Rprune-deferred-decls 2>&1 \
+// RUN:   | FileCheck -check-prefix=REMARK %s
+
+// REMARK: remark: skipped 1 unreferenced vtable and 0 unreferenced deferred definitions
+
+// Defining a constructor makes Sema mark the vtable used, even though nothing
+// in this file ever constructs an Unused.
+struct Unused {
+  Unused() {}
+  virtual void f() {}
+};
+
+struct Used {
+  Used() {}
+  virtual void g() {}
+};
+
+void use() { Used u; }
+
+// Instantiated for a caller that is never emitted, but 'used' requires its
+// definition regardless.
+template <typename T> __attribute__((used)) void keep() {}
+inline void unemitted() { keep<int>(); }
+
+// CHECK-DAG: @_ZTV4Used = linkonce_odr
+// CHECK-DAG: define linkonce_odr void @_ZN4Used1gEv(
+// CHECK-DAG: define linkonce_odr void @_Z4keepIiEvv(
+// DEFAULT-DAG: @_ZTV6Unused = linkonce_odr
+// DEFAULT-DAG: define linkonce_odr void @_ZN6Unused1fEv(
+// PRUNE-NOT: _ZTV6Unused
+// PRUNE-NOT: define {{.*}} @_ZN6Unused1fEv(
@@ -0,0 +1,6 @@
+static inline int header_func(int x) {
+#if 0
+  x = 2;
+#endif
+  return x;
+}
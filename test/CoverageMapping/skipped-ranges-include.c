@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -fprofile-instrument=clang -fcoverage-mapping -dump-coverage-mapping -emit-llvm-only -main-file-name skipped-ranges-include.c %s | FileCheck %s
+
+// Each function only gets the skipped ranges of its own files and lines.
+
+                    // CHECK-LABEL: before:
+void before() {     // CHECK-NEXT: File 0, [[@LINE]]:15 -> [[@LINE+4]]:2 = #0
+#ifdef UNDEFINED    // CHECK-NEXT: Skipped,File 0, [[@LINE]]:1 -> [[@LINE+3]]:1 = 0
+  int x;
+#endif
+}
+
+#include "Inputs/skipped-ranges.h"
+
+                    // CHECK-LABEL: after:
+int after() {       // CHECK-NEXT: File 0, [[@LINE]]:13 -> [[@LINE+5]]:2 = #0
+#if 0               // CHECK-NEXT: Skipped,File 0, [[@LINE]]:1 -> [[@LINE+3]]:1 = 0
+  return 1;
+#endif
+  return header_func(0);
+}
+
+// CHECK-LABEL: header_func:
+// CHECK-NEXT: File 0, 1:38 -> 6:2 = #0
+// CHECK-NEXT: Skipped,File 0, 2:1 -> 5:1 = 0
@@ -0,0 +1,6 @@
+struct S {
+  int x;
+  static int y;
+  void f();
+  typedef int T;
+};
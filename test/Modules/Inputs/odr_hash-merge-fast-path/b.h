@@ -0,0 +1,7 @@
+struct S {
+  int x;
+  static int y;
+  void f();
+  typedef int T;
+};
+int from_b();
@@ -0,0 +1,4 @@
+int b(void);
+int b_redecl(void);
+#define B_MACRO 1
+struct S { int x; };
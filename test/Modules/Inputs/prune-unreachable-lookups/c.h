@@ -0,0 +1 @@
+struct S { int x; };
@@ -0,0 +1,23 @@
+// RUN: rm -rf %t
+// Build the index with only one module in the cache.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DIMPORT_MODULE
+// RUN: ls %t | grep modules.idx
+// Add a second module; the entries for the first one are carried over.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DIMPORT_DEPENDS
+// Use the updated index for both modules.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DIMPORT_MODULE -DIMPORT_DEPENDS -print-stats 2>&1 | FileCheck %s
+
+// expected-no-diagnostics
+#ifdef IMPORT_DEPENDS
+@import DependsOnModule;
+#endif
+#ifdef IMPORT_MODULE
+@import Module;
+
+int *get_sub() {
+  return Module_Sub;
+}
+#endif
+
+// CHECK: *** Global Module Index Statistics:
+// CHECK: identifier lookups succeeded
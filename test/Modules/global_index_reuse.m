@@ -0,0 +1,22 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t
+// Build the index with only one module in the cache; nothing can be reused.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DIMPORT_MODULE -print-stats 2>&1 | FileCheck %s --check-prefix=FRESH
+// Add a module that imports the first one. The unchanged module file of the
+// first one is carried over instead of being read again.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DIMPORT_DEPENDS -print-stats 2>&1 | FileCheck %s --check-prefix=REUSE
+
+// expected-no-diagnostics
+#ifdef IMPORT_DEPENDS
+@import DependsOnModule;
+#endif
+#ifdef IMPORT_MODULE
+@import Module;
+#endif
+
+// FRESH-NOT: module files carried over from the previous index
+// FRESH: {{[1-9][0-9]*}} global-module-index - The # of module files read to build the index
+// FRESH-NOT: module files carried over from the previous index
+
+// REUSE-DAG: {{[1-9][0-9]*}} global-module-index - The # of module files carried over from the previous index
+// REUSE-DAG: {{[1-9][0-9]*}} global-module-index - The # of module files read to build the index
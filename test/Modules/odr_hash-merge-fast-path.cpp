@@ -0,0 +1,19 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/odr_hash-merge-fast-path -std=c++11 -x c++ %s \
+// RUN:   -verify -print-stats 2>&1 | FileCheck %s
+
+// Members of the definition of S from B are known to be in the definition
+// from A because both have the same ODR hash.
+// CHECK: {{[1-9][0-9]*}} merged members checked by ODR hash
+
+#include "a.h"
+#include "b.h"
+
+int g(S s) {
+  S::T t = s.x + S::y + from_b();
+  s.f();
+  return t;
+}
+
+// expected-no-diagnostics
@@ -0,0 +1,38 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/prune-unreachable-lookups -verify %s
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/prune-unreachable-lookups \
+// RUN:   -fmodules-prune-unreachable-lookups -verify %s -DPRUNE
+
+@import A;
+
+int use_a(void) { return a(); }
+
+#ifdef PRUNE
+// Module B is imported by A but not exported, so its module file is not
+// searched.
+int use_b(void) { return b(); } // expected-warning {{implicit declaration of function 'b' is invalid in C99}}
+#else
+int use_b(void) { return b(); } // expected-error {{declaration of 'b' must be imported from module 'B' before it is required}}
+// expected-note@Inputs/prune-unreachable-lookups/b.h:1 {{previous}}
+#endif
+
+#ifdef PRUNE
+// Redeclaration lookup does not find the hidden declaration in B either.
+double b_redecl(void);
+#else
+double b_redecl(void); // expected-error {{conflicting types for 'b_redecl'}}
+// expected-note@Inputs/prune-unreachable-lookups/b.h:2 {{previous declaration is here}}
+#endif
+
+// The definition of S in C is merged with the one in B, even though B's
+// module file is not searched by name lookups.
+@import C;
+
+int use_s(struct S *s) { return s->x; }
+
+// Once B is imported, its module file is searched.
+@import B;
+
+int use_b_again(void) { return b() + B_MACRO; }
@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: echo 'int f(void);' > %t/a.h
+// RUN: echo 'int g(void);' > %t/b.h
+// RUN: echo 'int h(void);' > %t/c.h
+
+// RUN: %clang_cc1 -fsyntax-only %s -Rchain-include-cache \
+// RUN:   -chain-include %t/a.h -chain-include %t/b.h -chain-include %t/c.h \
+// RUN:   -chain-include-cache-path %t/cache 2>&1 | FileCheck %s -check-prefix=BUILD
+// BUILD: building precompiled header for chained include '{{.*}}a.h'
+// BUILD: building precompiled header for chained include '{{.*}}b.h'
+// BUILD: building precompiled header for chained include '{{.*}}c.h'
+
+// RUN: %clang_cc1 -fsyntax-only %s -Rchain-include-cache \
+// RUN:   -chain-include %t/a.h -chain-include %t/b.h -chain-include %t/c.h \
+// RUN:   -chain-include-cache-path %t/cache 2>&1 | FileCheck %s -check-prefix=REUSE
+// REUSE: reusing cached precompiled header for chained include '{{.*}}a.h'
+// REUSE: reusing cached precompiled header for chained include '{{.*}}b.h'
+// REUSE: reusing cached precompiled header for chained include '{{.*}}c.h'
+
+// Editing a header rebuilds it and everything chained after it.
+// RUN: echo 'int g2(void);' >> %t/b.h
+// RUN: %clang_cc1 -fsyntax-only %s -Rchain-include-cache \
+// RUN:   -chain-include %t/a.h -chain-include %t/b.h -chain-include %t/c.h \
+// RUN:   -chain-include-cache-path %t/cache 2>&1 | FileCheck %s -check-prefix=EDIT
+// EDIT: reusing cached precompiled header for chained include '{{.*}}a.h'
+// EDIT: building precompiled header for chained include '{{.*}}b.h'
+// EDIT: building precompiled header for chained include '{{.*}}c.h'
+
+int test(void) {
+  return f() + g() + h();
+}
@@ -0,0 +1,36 @@
+// RUN: rm -f %t.prof
+// RUN: %clang_cc1 -emit-pch -o %t.pch %S/Inputs/chain-decls1.h
+
+// The first compilation records the declarations it deserializes.
+// RUN: %clang_cc1 -include-pch %t.pch -pch-prefetch-profile %t.prof \
+// RUN:   -fsyntax-only -verify -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NO-PREFETCH
+// RUN: FileCheck %s < %t.prof
+
+// The second compilation prefetches them and records them again.
+// RUN: %clang_cc1 -include-pch %t.pch -pch-prefetch-profile %t.prof \
+// RUN:   -fsyntax-only -verify -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=PREFETCH
+// RUN: FileCheck %s < %t.prof
+
+// A profile recorded against another PCH is ignored.
+// RUN: cp %t.pch %t-other.pch
+// RUN: %clang_cc1 -include-pch %t-other.pch -pch-prefetch-profile %t.prof \
+// RUN:   -fsyntax-only -verify -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NO-PREFETCH
+
+// CHECK: {{.*}}.pch {{[0-9]+}} {{[0-9]+}}
+// CHECK-NEXT: {{^[0-9]+$}}
+
+// NO-PREFETCH: *** AST File Statistics:
+// NO-PREFETCH-NOT: prefetched from the profile
+
+// PREFETCH: *** AST File Statistics:
+// PREFETCH: {{[1-9][0-9]*}} declarations prefetched from the profile
+
+// expected-no-diagnostics
+
+void h() {
+  f();
+  struct one x;
+}
@@ -0,0 +1,80 @@
+// Test without pch.
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -include %s -fsyntax-only -verify %s
+
+// Test with pch, with and without stored record layouts.
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -x c++-header -emit-pch -o %t.nolayouts.pch %s
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -include-pch %t.nolayouts.pch -fsyntax-only -verify -print-stats %s 2>&1 | FileCheck %s -check-prefix=NOLAYOUTS
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -x c++-header -fmodules-record-layouts -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -include-pch %t.pch -fsyntax-only -verify -print-stats %s 2>&1 | FileCheck %s -check-prefix=STATS
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-linux-gnu -include-pch %t.pch -fsyntax-only -fdump-record-layouts %s | FileCheck %s
+
+// expected-no-diagnostics
+
+#ifndef HEADER
+#define HEADER
+
+struct A {
+  int a;
+  virtual void f();
+};
+
+struct B : A {
+  char b;
+};
+
+struct C : virtual A {
+  short c;
+};
+
+template <typename T> struct Pair {
+  T first;
+  char second;
+};
+
+inline int g() { return sizeof(Pair<long>); }
+
+#else
+
+static_assert(sizeof(A) == 16, "");
+static_assert(sizeof(B) == 16, "");
+static_assert(sizeof(C) == 32, "");
+static_assert(sizeof(Pair<long>) == 16, "");
+
+// NOLAYOUTS-NOT: record layouts read
+
+// STATS: 4/{{[0-9]+}} record layouts read
+
+// CHECK:      *** Dumping AST Record Layout
+// CHECK-NEXT:          0 | struct A
+// CHECK-NEXT:          0 |   (A vtable pointer)
+// CHECK-NEXT:          8 |   int a
+// CHECK-NEXT:            | [sizeof=16, dsize=12, align=8,
+// CHECK-NEXT:            |  nvsize=12, nvalign=8]
+
+// CHECK:      *** Dumping AST Record Layout
+// CHECK-NEXT:          0 | struct B
+// CHECK-NEXT:          0 |   struct A (primary base)
+// CHECK-NEXT:          0 |     (A vtable pointer)
+// CHECK-NEXT:          8 |     int a
+// CHECK-NEXT:         12 |   char b
+// CHECK-NEXT:            | [sizeof=16, dsize=13, align=8,
+// CHECK-NEXT:            |  nvsize=13, nvalign=8]
+
+// CHECK:      *** Dumping AST Record Layout
+// CHECK-NEXT:          0 | struct C
+// CHECK-NEXT:          0 |   (C vtable pointer)
+// CHECK-NEXT:          8 |   short c
+// CHECK-NEXT:         16 |   struct A (virtual base)
+// CHECK-NEXT:         16 |     (A vtable pointer)
+// CHECK-NEXT:         24 |     int a
+// CHECK-NEXT:            | [sizeof=32, dsize=28, align=8,
+// CHECK-NEXT:            |  nvsize=10, nvalign=8]
+
+// CHECK:      *** Dumping AST Record Layout
+// CHECK-NEXT:          0 | struct Pair<long>
+// CHECK-NEXT:          0 |   long first
+// CHECK-NEXT:          8 |   char second
+// CHECK-NEXT:            | [sizeof=16, dsize=16, align=8,
+// CHECK-NEXT:            |  nvsize=16, nvalign=8]
+
+#endif
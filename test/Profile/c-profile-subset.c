@@ -0,0 +1,56 @@
+// Test that a translation unit can write out the profile records it uses and
+// read them back from that subset instead of the full profile.
+
+// RUN: llvm-profdata merge %S/Inputs/c-unprofiled.proftext -o %t.profdata
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-subset-output=%t.subset.profdata | FileCheck %s
+// RUN: llvm-profdata show -all-functions %t.subset.profdata | FileCheck %s -check-prefix=SUBSET
+
+// Use the subset. The profile summary is carried over from the full profile.
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-use-subset-path=%t.subset.profdata | FileCheck %s
+
+// A subset lacking a record falls back to the full profile.
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o /dev/null -emit-llvm -fprofile-instrument-use-path=%t.profdata -DEMPTY_SUBSET -fprofile-instrument-subset-output=%t.empty.profdata
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-use-subset-path=%t.empty.profdata | FileCheck %s
+
+// RUN: not %clang_cc1 -emit-llvm %s -o /dev/null -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-use-subset-path=%t.nonexistent.profdata 2>&1 | FileCheck %s -check-prefix=MISSING
+
+// An up-to-date subset does not need the full profile. Clobber its header
+// while keeping its size and modification time.
+// RUN: cp -p %t.profdata %t.orig.profdata
+// RUN: dd if=/dev/zero of=%t.profdata bs=8 count=1 conv=notrunc
+// RUN: touch -r %t.orig.profdata %t.profdata
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-use-subset-path=%t.subset.profdata | FileCheck %s
+
+// A subset taken from an older profile is ignored.
+// RUN: llvm-profdata merge -weighted-input=3,%S/Inputs/c-unprofiled.proftext -o %t.profdata
+// RUN: touch -t 200001010000 %t.profdata
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-profile-subset.c -I %S/Inputs/ %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-instrument-use-subset-path=%t.subset.profdata | FileCheck %s -check-prefix=STALE
+
+// RUN: not %clang_cc1 -emit-llvm %s -o /dev/null -fprofile-instrument-use-subset-path=%t.subset.profdata 2>&1 | FileCheck %s -check-prefix=NO-USE-PATH
+// RUN: not %clang_cc1 -emit-llvm %s -o /dev/null -fprofile-instrument-subset-output=%t.out.profdata 2>&1 | FileCheck %s -check-prefix=NO-USE-PATH
+
+// SUBSET-DAG: function_in_header:
+// SUBSET-DAG: __clang_profile_subset_source:
+// SUBSET: Functions shown: 2
+
+// MISSING: error: Could not read profile {{.*}}.nonexistent.profdata:
+
+// NO-USE-PATH: error: invalid argument '-fprofile-{{instrument-use-subset-path|instrument-subset-output}}={{.*}}' only allowed with '-fprofile-instrument-use-path='
+
+#ifndef EMPTY_SUBSET
+#include "profiled_header.h"
+
+// CHECK-LABEL: define void @function_in_header
+// CHECK: br {{.*}} !prof ![[PD:[0-9]+]]
+#endif
+
+void some_unprofiled_function(int i) {}
+
+// CHECK-DAG: !{i32 1, !"ProfileSummary", {{![0-9]+}}}
+// CHECK-DAG: !{!"MaxFunctionCount", i64 1}
+// CHECK-DAG: ![[PD]] = !{!"branch_weights", i32 1, i32 2}
+
+// STALE-LABEL: define void @function_in_header
+// STALE: br {{.*}} !prof ![[PD:[0-9]+]]
+// STALE-DAG: !{!"MaxFunctionCount", i64 3}
+// STALE-DAG: ![[PD]] = !{!"branch_weights", i32 1, i32 4}
@@ -25,9 +25,11 @@
 #include "clang/Index/USRGeneration.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include <sstream>
 #include <string>
 #include <vector>
@@ -39,13 +41,34 @@ using namespace clang::tooling;
 
 static cl::OptionCategory ClangFnMapGenCategory("clang-fnmapgen options");
 
+static cl::opt<std::string> BinaryOutput(
+    "binary-output",
+    cl::desc("Write the index of all the source files to <file> in the "
+             "binary format instead of printing it. Functions defined in more "
+             "than one source file are left out."),
+    cl::value_desc("file"), cl::cat(ClangFnMapGenCategory));
+
+/// The index of all the source files, if written in the binary format.
+static llvm::StringMap<std::string> GlobalIndex;
+/// The functions defined in more than one source file.
+static llvm::StringSet<> ConflictingNames;
+
 class MapFunctionNamesConsumer : public ASTConsumer {
 public:
   MapFunctionNamesConsumer(ASTContext &Context) : Ctx(Context) {}
 
   ~MapFunctionNamesConsumer() {
-    // Flush results to standard output.
-    llvm::outs() << createCrossTUIndexString(Index);
+    if (BinaryOutput.empty()) {
+      // Flush results to standard output.
+      llvm::outs() << createCrossTUIndexString(Index);
+      return;
+    }
+
+    for (const auto &E : Index) {
+      auto Inserted = GlobalIndex.try_emplace(E.getKey(), E.getValue());
+      if (!Inserted.second && Inserted.first->getValue() != E.getValue())
+        ConflictingNames.insert(E.getKey());
+    }
   }
 
   virtual void HandleTranslationUnit(ASTContext &Ctx) {
@@ -119,6 +142,25 @@ int main(int argc, const char **argv) {
 
   ClangTool Tool(OptionsParser.getCompilations(),
                  OptionsParser.getSourcePathList());
-  Tool.run(newFrontendActionFactory<MapFunctionNamesAction>().get());
-  return 0;
+  int Result =
+      Tool.run(newFrontendActionFactory<MapFunctionNamesAction>().get());
+
+  // Scripts that read the text output expect it to succeed even if some
+  // files failed to parse.
+  if (BinaryOutput.empty())
+    return 0;
+
+  for (const auto &Name : ConflictingNames)
+    GlobalIndex.erase(Name.getKey());
+
+  std::error_code EC;
+  ToolOutputFile Out(BinaryOutput, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "error: cannot open '" << BinaryOutput << "': " << EC.message()
+           << '\n';
+    return 1;
+  }
+  Out.os() << createCrossTUBinaryIndex(GlobalIndex);
+  Out.keep();
+  return Result;
 }
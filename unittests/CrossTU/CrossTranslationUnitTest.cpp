@@ -11,6 +11,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -24,8 +25,9 @@ namespace {
 
 class CTUASTConsumer : public clang::ASTConsumer {
 public:
-  explicit CTUASTConsumer(clang::CompilerInstance &CI, bool *Success)
-      : CTU(CI), Success(Success) {}
+  explicit CTUASTConsumer(clang::CompilerInstance &CI, bool *Success,
+                          bool BinaryIndex)
+      : CTU(CI), Success(Success), BinaryIndex(BinaryIndex) {}
 
   void HandleTranslationUnit(ASTContext &Ctx) {
     const TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
@@ -50,7 +52,13 @@ public:
     ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "txt", IndexFD,
                                                     IndexFileName));
     llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
-    IndexFile.os() << "c:@F@f#I# " << ASTFileName << "\n";
+    if (BinaryIndex) {
+      llvm::StringMap<std::string> Index;
+      Index["c:@F@f#I#"] = ASTFileName.str();
+      IndexFile.os() << createCrossTUBinaryIndex(Index);
+    } else {
+      IndexFile.os() << "c:@F@f#I# " << ASTFileName << "\n";
+    }
     IndexFile.os().flush();
     EXPECT_TRUE(llvm::sys::fs::exists(IndexFileName));
 
@@ -71,6 +79,10 @@ public:
     EXPECT_TRUE(llvm::sys::fs::exists(ASTFileName));
 
     // Load the definition from the AST file.
+    if (BinaryIndex) {
+      CTU.setLazyDefinitionLookup(true);
+      CTU.setLoadedASTMemoryLimit(1);
+    }
     llvm::Expected<const FunctionDecl *> NewFDorError =
         CTU.getCrossTUDefinition(FD, "", IndexFileName);
     EXPECT_TRUE((bool)NewFDorError);
@@ -82,16 +94,118 @@ public:
 private:
   CrossTranslationUnitContext CTU;
   bool *Success;
+  bool BinaryIndex;
 };
 
 class CTUAction : public clang::ASTFrontendAction {
 public:
-  CTUAction(bool *Success) : Success(Success) {}
+  CTUAction(bool *Success, bool BinaryIndex = false)
+      : Success(Success), BinaryIndex(BinaryIndex) {}
+
+protected:
+  std::unique_ptr<clang::ASTConsumer>
+  CreateASTConsumer(clang::CompilerInstance &CI, StringRef) override {
+    return llvm::make_unique<CTUASTConsumer>(CI, Success, BinaryIndex);
+  }
+
+private:
+  bool *Success;
+  bool BinaryIndex;
+};
+
+/// Saves the AST of \p SourceText to a temporary file. The file and its
+/// source file are removed when \p Files is destroyed.
+void createTemporaryAST(
+    StringRef SourceText,
+    std::vector<std::unique_ptr<llvm::ToolOutputFile>> &Files,
+    llvm::SmallString<256> &ASTFileName) {
+  int ASTFD;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("ast", "ast", ASTFD, ASTFileName));
+  Files.push_back(llvm::make_unique<llvm::ToolOutputFile>(ASTFileName, ASTFD));
+
+  int SourceFD;
+  llvm::SmallString<256> SourceFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("input", "cpp", SourceFD,
+                                                  SourceFileName));
+  Files.push_back(
+      llvm::make_unique<llvm::ToolOutputFile>(SourceFileName, SourceFD));
+  Files.back()->os() << SourceText;
+  Files.back()->os().flush();
+
+  std::unique_ptr<ASTUnit> Unit =
+      tooling::buildASTFromCode(SourceText, SourceFileName);
+  Unit->Save(ASTFileName.str());
+  EXPECT_TRUE(llvm::sys::fs::exists(ASTFileName));
+}
+
+class CTUUnloadingConsumer : public clang::ASTConsumer {
+public:
+  CTUUnloadingConsumer(clang::CompilerInstance &CI, bool *Success)
+      : CTU(CI), Success(Success) {}
+
+  void HandleTranslationUnit(ASTContext &Ctx) {
+    const FunctionDecl *F = nullptr, *G = nullptr;
+    for (const Decl *D : Ctx.getTranslationUnitDecl()->decls()) {
+      if (const auto *FD = dyn_cast<FunctionDecl>(D)) {
+        if (FD->getName() == "f")
+          F = FD;
+        else if (FD->getName() == "g")
+          G = FD;
+      }
+    }
+    ASSERT_TRUE(F && G);
+
+    // Each function is defined in its own AST file.
+    std::vector<std::unique_ptr<llvm::ToolOutputFile>> Files;
+    llvm::SmallString<256> FASTFileName, GASTFileName;
+    createTemporaryAST("int f(int) { return 0; }\n", Files, FASTFileName);
+    createTemporaryAST("int g(int) { return 1; }\n", Files, GASTFileName);
+
+    int IndexFD;
+    llvm::SmallString<256> IndexFileName;
+    ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "txt", IndexFD,
+                                                    IndexFileName));
+    llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
+    IndexFile.os() << "c:@F@f#I# " << FASTFileName << "\n"
+                   << "c:@F@g#I# " << GASTFileName << "\n";
+    IndexFile.os().flush();
+
+    // Every AST exceeds the limit, so only the one in use stays loaded.
+    CTU.setLoadedASTMemoryLimit(1);
+    llvm::Expected<const FunctionDecl *> NewF =
+        CTU.getCrossTUDefinition(F, "", IndexFileName);
+    ASSERT_TRUE((bool)NewF);
+    EXPECT_EQ(CTU.getNumLoadedASTUnits(), 1u);
+
+    llvm::Expected<const FunctionDecl *> NewG =
+        CTU.getCrossTUDefinition(G, "", IndexFileName);
+    ASSERT_TRUE((bool)NewG);
+    EXPECT_EQ(CTU.getNumLoadedASTUnits(), 1u);
+
+    // The unloaded AST of f is loaded again when it is needed.
+    llvm::Expected<ASTUnit *> FUnit =
+        CTU.loadExternalAST("c:@F@f#I#", "", IndexFileName);
+    ASSERT_TRUE((bool)FUnit);
+    EXPECT_EQ(CTU.getNumLoadedASTUnits(), 2u);
+
+    *Success = *NewF && (*NewF)->hasBody() && *NewG && (*NewG)->hasBody() &&
+               *FUnit;
+  }
+
+private:
+  CrossTranslationUnitContext CTU;
+  bool *Success;
+};
+
+class CTUUnloadingAction : public clang::ASTFrontendAction {
+public:
+  CTUUnloadingAction(bool *Success) : Success(Success) {}
 
 protected:
   std::unique_ptr<clang::ASTConsumer>
   CreateASTConsumer(clang::CompilerInstance &CI, StringRef) override {
-    return llvm::make_unique<CTUASTConsumer>(CI, Success);
+    return llvm::make_unique<CTUUnloadingConsumer>(CI, Success);
   }
 
 private:
@@ -106,6 +220,20 @@ TEST(CrossTranslationUnit, CanLoadFunctionDefinition) {
   EXPECT_TRUE(Success);
 }
 
+TEST(CrossTranslationUnit, CanLoadFunctionDefinitionWithBinaryIndex) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(new CTUAction(&Success, true),
+                                     "int f(int);"));
+  EXPECT_TRUE(Success);
+}
+
+TEST(CrossTranslationUnit, LeastRecentlyUsedASTIsUnloaded) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(new CTUUnloadingAction(&Success),
+                                     "int f(int); int g(int);"));
+  EXPECT_TRUE(Success);
+}
+
 TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
   llvm::StringMap<std::string> Index;
   Index["a"] = "/b/f1";
@@ -133,6 +261,57 @@ TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
     EXPECT_TRUE(Index.count(E.getKey()));
 }
 
+TEST(CrossTranslationUnit, BinaryIndexFormatCanBeParsed) {
+  llvm::StringMap<std::string> Index;
+  Index["a"] = "/b/f1";
+  Index["c"] = "/d/f2";
+  Index["e"] = "/f/f3";
+  std::string IndexData = createCrossTUBinaryIndex(Index);
+
+  int IndexFD;
+  llvm::SmallString<256> IndexFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "bin", IndexFD,
+                                                  IndexFileName));
+  llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
+  IndexFile.os() << IndexData;
+  IndexFile.os().flush();
+  EXPECT_TRUE(llvm::sys::fs::exists(IndexFileName));
+  llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
+      parseCrossTUIndex(IndexFileName, "/ctudir");
+  EXPECT_TRUE((bool)IndexOrErr);
+  llvm::StringMap<std::string> ParsedIndex = IndexOrErr.get();
+  EXPECT_EQ(ParsedIndex.size(), Index.size());
+  EXPECT_EQ(ParsedIndex["a"], "/ctudir/b/f1");
+  EXPECT_EQ(ParsedIndex["c"], "/ctudir/d/f2");
+  EXPECT_EQ(ParsedIndex["e"], "/ctudir/f/f3");
+}
+
+TEST(CrossTranslationUnit, BinaryIndexWithInvalidBucketCountIsRejected) {
+  llvm::StringMap<std::string> Index;
+  Index["a"] = "/b/f1";
+  std::string IndexData = createCrossTUBinaryIndex(Index);
+
+  // The offset of the buckets follows the 8 byte magic number. Make the
+  // bucket count point past the end of the file.
+  uint32_t BucketOffset = llvm::support::endian::read32le(IndexData.data() + 8);
+  ASSERT_LE(BucketOffset + 4, IndexData.size());
+  llvm::support::endian::write32le(&IndexData[BucketOffset], 1u << 30);
+
+  int IndexFD;
+  llvm::SmallString<256> IndexFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "bin", IndexFD,
+                                                  IndexFileName));
+  llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
+  IndexFile.os() << IndexData;
+  IndexFile.os().flush();
+  llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
+      parseCrossTUIndex(IndexFileName, "");
+  ASSERT_FALSE((bool)IndexOrErr);
+  llvm::handleAllErrors(IndexOrErr.takeError(), [](const IndexError &IE) {
+    EXPECT_EQ(IE.getCode(), index_error_code::invalid_index_format);
+  });
+}
+
 TEST(CrossTranslationUnit, CTUDirIsHandledCorrectly) {
   llvm::StringMap<std::string> Index;
   Index["a"] = "/b/c/d";